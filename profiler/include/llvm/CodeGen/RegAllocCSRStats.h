@@ -0,0 +1,81 @@
+#ifndef LLVM_CODEGEN_REGALLOCCSRSTATS_H
+#define LLVM_CODEGEN_REGALLOCCSRSTATS_H
+
+#include "llvm/CodeGen/LiveRegMatrix.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/Register.h"
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocCSRDecision - one RAGreedy::tryAssignCSRFirstTime call
+// tryAssign found an unused callee-saved physReg, and the allocator weighs the CSR first use
+// cost against spilling (RS_Spill ranges) or pre-splitting (ranges before RS_Split) instead.
+struct RegAllocCSRDecision {
+  enum Outcome : uint8_t {
+    // take the callee-saved register
+    CSR_Use,
+    // spill cost below the CSR cost - tryAssign keeps away from CSRs from then on
+    CSR_Spill,
+    // region split below the CSR cost - the range was pre-split
+    CSR_Split
+  };
+
+  enum Alternative : uint8_t {
+    // the stage has no alternative, the CSR is taken as is
+    CSA_None,
+    CSA_Spill,
+    CSA_Split
+  };
+
+  uint32_t vReg;
+  uint16_t physReg;
+  uint8_t stage;
+  uint8_t alternative;
+  uint8_t outcome;
+  // altCost when no alternative cost is known: no region split was found below csrCost
+  // (calculateRegionSplitCost only prices candidates cheaper than its bound), or the stage
+  // has no alternative
+  static const uint64_t NoAltCost = UINT64_MAX;
+
+  // block frequencies
+  uint64_t csrCost;
+  uint64_t altCost;
+};
+
+// RegAllocCSRStats - callee-saved register first use decisions of a function
+class RegAllocCSRStats {
+
+  private:
+    // the function's CSR first use cost, see RAGreedy::initializeCSRCost
+    uint64_t csrCost = 0;
+
+    std::vector<RegAllocCSRDecision> decisions;
+
+    // callee-saved registers of the function, and the ones holding allocated vRegs
+    uint32_t numCSRs = 0;
+    uint32_t numUsedCSRs = 0;
+
+  public:
+    // Resets the stats for a new function - keeps the storage
+    void clear(uint64_t csrCost) {
+      this->csrCost = csrCost;
+      decisions.clear();
+      numCSRs = numUsedCSRs = 0;
+    }
+
+    void recordDecision(Register reg, unsigned physReg, unsigned stage,
+                        RegAllocCSRDecision::Alternative alternative, uint64_t altCost,
+                        RegAllocCSRDecision::Outcome outcome);
+
+    // Counts the callee-saved registers the allocation clobbered
+    void countUsedCSRs(const MachineRegisterInfo& MRI, const LiveRegMatrix& Matrix);
+
+    uint64_t getCSRCost() const { return csrCost; }
+    const std::vector<RegAllocCSRDecision>& getDecisions() const { return decisions; }
+    uint32_t getNumCSRs() const { return numCSRs; }
+    uint32_t getNumUsedCSRs() const { return numUsedCSRs; }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCCSRSTATS_H
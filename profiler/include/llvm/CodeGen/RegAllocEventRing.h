@@ -0,0 +1,108 @@
+#ifndef LLVM_CODEGEN_REGALLOCEVENTRING_H
+#define LLVM_CODEGEN_REGALLOCEVENTRING_H
+
+#include "llvm/CodeGen/LiveInterval.h"
+#include "llvm/CodeGen/Register.h"
+#include "llvm/CodeGen/SlotIndexes.h"
+#include <cstdint>
+
+using namespace llvm;
+
+// RegAllocEventKind - what the greedy allocator did to a live range
+enum RegAllocEventKind : uint8_t {
+  // tryAssign found a free physReg
+  RAE_Assign,
+  // evictInterference freed physReg for the vReg by evicting interference
+  RAE_Evict,
+  // the vReg was evicted from physReg (one event per evictee)
+  RAE_Evicted,
+  // tryRegionSplit / tryBlockSplit / tryLocalSplit / tryInstructionSplit split the vReg
+  RAE_RegionSplit,
+  RAE_BlockSplit,
+  RAE_LocalSplit,
+  RAE_InstructionSplit,
+  // the vReg was spilled (or deferred to RS_Memory)
+  RAE_Spill,
+  // tryLastChanceRecoloring returned, physReg is its result (0 on failure)
+  RAE_LastChanceRecoloring,
+  // tryHintRecoloring moved the vReg to physReg
+  RAE_HintRecoloring,
+  RAE_NumKinds
+};
+
+// Name of the event kind as used in the text output
+const char* getRegAllocEventKindName(RegAllocEventKind kind);
+
+// RegAllocEvent - compact binary record of one allocator decision
+struct RegAllocEvent {
+  // virtReg index
+  uint32_t vReg;
+  // live interval's SlotIndex range, as distance from the function's first SlotIndex
+  uint32_t start;
+  uint32_t end;
+  // physReg involved in the decision, 0 if none
+  uint16_t physReg;
+  // RegAllocEventKind
+  uint8_t kind;
+  // RAGreedy::LiveRangeStage of the vReg when the event was recorded
+  uint8_t stage;
+};
+
+static_assert(sizeof(RegAllocEvent) == 16, "RegAllocEvent should stay 16 bytes");
+
+// RegAllocEventRing - fixed-size, allocation-free ring of the latest allocator events
+// Recording is a handful of stores into a preallocated array, cheap enough to leave on in
+// production builds. Once more than Capacity events were recorded in a function the oldest
+// ones are overwritten, numDropped() says how many.
+class RegAllocEventRing {
+
+  public:
+    // must be a power of two
+    static const unsigned Capacity = 1 << 14;
+
+  private:
+    RegAllocEvent events[Capacity];
+
+    // total number of events recorded since clear(), the next slot is head % Capacity
+    uint64_t head = 0;
+
+    // events recorded per kind since clear() - counts dropped events too
+    uint64_t kindCounts[RAE_NumKinds] = {};
+
+    // first SlotIndex of the current function, event ranges are relative to it
+    SlotIndex zeroIndex;
+
+  public:
+    // Resets the ring for a new function
+    void clear(SlotIndex firstIndex) {
+      head = 0;
+      for (auto& count : kindCounts)
+        count = 0;
+      zeroIndex = firstIndex;
+    }
+
+    void record(RegAllocEventKind kind, const LiveInterval& VirtReg, unsigned physReg, unsigned stage) {
+      RegAllocEvent& E = events[head++ & (Capacity - 1)];
+      E.vReg = Register::virtReg2Index(VirtReg.reg);
+      E.start = VirtReg.empty() ? 0 : zeroIndex.distance(VirtReg.beginIndex());
+      E.end = VirtReg.empty() ? 0 : zeroIndex.distance(VirtReg.endIndex());
+      E.physReg = physReg;
+      E.kind = kind;
+      E.stage = stage;
+      kindCounts[kind]++;
+    }
+
+    uint64_t numRecorded() const { return head; }
+
+    uint64_t numDropped() const { return head > Capacity ? head - Capacity : 0; }
+
+    uint64_t count(RegAllocEventKind kind) const { return kindCounts[kind]; }
+
+    // Calls fn on every retained event, oldest first
+    template <typename Fn> void forEach(Fn fn) const {
+      for (uint64_t i = numDropped(); i != head; ++i)
+        fn(events[i & (Capacity - 1)]);
+    }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCEVENTRING_H
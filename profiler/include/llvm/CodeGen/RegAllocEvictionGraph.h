@@ -0,0 +1,77 @@
+#ifndef LLVM_CODEGEN_REGALLOCEVICTIONGRAPH_H
+#define LLVM_CODEGEN_REGALLOCEVICTIONGRAPH_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/CodeGen/Register.h"
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocEviction - one edge of the eviction graph: evictor took physReg from evictee
+struct RegAllocEviction {
+  // virtReg indices
+  uint32_t evictor;
+  uint32_t evictee;
+  // cascade number the evictee inherited from the evictor
+  uint32_t cascade;
+  // EvictionCost of the interference the evictor chose to evict
+  uint32_t brokenHints;
+  float maxWeight;
+  uint16_t physReg;
+};
+
+// RegAllocEvictionGraph - every eviction of a function, in the order they happened
+// Unlike the event ring nothing is dropped, so the graph can be walked afterwards. An
+// evicted vReg is re-queued and may evict others in turn - following evictee -> evictor
+// through later edges gives the eviction chains. Edges are time ordered, so this is a DAG
+// even if a vReg is evicted several times.
+class RegAllocEvictionGraph {
+
+  private:
+    std::vector<RegAllocEviction> edges;
+
+    // longest chain of edges ending in an eviction of the vReg, and the last edge of it
+    struct ChainEnd {
+      unsigned length;
+      unsigned edge;
+    };
+    DenseMap<uint32_t, ChainEnd> chainEnds;
+
+    // chain ending in edge e has length chainLength[e], previous edge chainPrev[e] (~0u if none)
+    std::vector<unsigned> chainLength;
+    std::vector<unsigned> chainPrev;
+
+    // times each vReg was evicted
+    DenseMap<uint32_t, unsigned> evictCounts;
+
+  public:
+    // Resets the graph for a new function - keeps the storage
+    void clear() {
+      edges.clear();
+      chainEnds.clear();
+      chainLength.clear();
+      chainPrev.clear();
+      evictCounts.clear();
+    }
+
+    void record(Register evictor, Register evictee, unsigned physReg, unsigned cascade,
+                unsigned brokenHints, float maxWeight);
+
+    const std::vector<RegAllocEviction>& getEdges() const { return edges; }
+
+    // every eviction sends the evictee back to the queue
+    size_t numRequeues() const { return edges.size(); }
+
+    // number of distinct vRegs that were evicted at least once
+    size_t numEvictedVRegs() const { return evictCounts.size(); }
+
+    // most evictions of a single vReg
+    unsigned maxEvictionsPerVReg() const;
+
+    // Edges of the longest eviction chain, first eviction first - empty without evictions
+    void getLongestChain(SmallVectorImpl<const RegAllocEviction*>& chain) const;
+};
+
+#endif // LLVM_CODEGEN_REGALLOCEVICTIONGRAPH_H
@@ -0,0 +1,62 @@
+#ifndef LLVM_CODEGEN_REGALLOCGAPKERNEL_H
+#define LLVM_CODEGEN_REGALLOCGAPKERNEL_H
+
+#include <cstdint>
+
+// Instruction set levels of the local split gap kernels, picked with -regalloc-gap-kernel
+enum RegAllocGapKernelKind {
+  // best level the host supports
+  RGK_Auto,
+  // portable loops, the stock LLVM code
+  RGK_Scalar,
+  // 4 lanes, the x86-64 baseline
+  RGK_SSE2,
+  // 8 lanes, checked for at run time
+  RGK_AVX2
+};
+
+// RegAllocGapKernel - array kernels of RAGreedy's local splitting
+//
+// calcGapWeights raises the gap weights covered by each interfering segment to the
+// segment's weight and finds those gaps by scanning the use slots, and tryLocalSplit takes
+// the max over a window of gap weights every time the window shrinks. Both are linear scans
+// over flat arrays - the use slots are turned into signed distances from the first use so
+// they compare as plain integers - and with a big single block they are most of the local
+// splitting time. Max is exact and order independent for the non-NaN spill weights, so
+// every level computes bit-identical results and the allocation does not change.
+class RegAllocGapKernel {
+
+  private:
+    RegAllocGapKernelKind kind;
+
+    unsigned (*findNotBelowFn)(const int32_t*, unsigned, unsigned, int32_t);
+    void (*raiseFn)(float*, unsigned, unsigned, float);
+    float (*maxFn)(const float*, unsigned, unsigned);
+
+  public:
+    // Levels the host does not support fall back to the next lower one
+    explicit RegAllocGapKernel(RegAllocGapKernelKind kind = RGK_Scalar);
+
+    // Level actually in use, never RGK_Auto
+    RegAllocGapKernelKind getKind() const { return kind; }
+
+    // Best level the host supports
+    static RegAllocGapKernelKind hostKind();
+
+    // First i in [begin, end) with keys[i] >= value, end if there is none
+    unsigned findNotBelow(const int32_t* keys, unsigned begin, unsigned end, int32_t value) const {
+      return findNotBelowFn(keys, begin, end, value);
+    }
+
+    // weights[i] = max(weights[i], weight) for i in [begin, end)
+    void raise(float* weights, unsigned begin, unsigned end, float weight) const {
+      raiseFn(weights, begin, end, weight);
+    }
+
+    // Max of weights[begin, end), the range must not be empty
+    float max(const float* weights, unsigned begin, unsigned end) const {
+      return maxFn(weights, begin, end);
+    }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCGAPKERNEL_H
@@ -0,0 +1,79 @@
+#ifndef LLVM_CODEGEN_REGALLOCHINTSTATS_H
+#define LLVM_CODEGEN_REGALLOCHINTSTATS_H
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/Register.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include <cstdint>
+
+using namespace llvm;
+
+// RegAllocCopyCost - full copies of a function and the ones left as real moves
+// A copy is broken when both of its ends are assigned and their physRegs differ, i.e. it
+// will not be removed as an identity copy by VirtRegRewriter. Copies with a spilled end
+// are spill code and are left out.
+struct RegAllocCopyCost {
+  uint32_t copies = 0;
+  uint32_t brokenCopies = 0;
+  // block frequencies relative to the entry block
+  double copyFreq = 0;
+  double brokenCopyFreq = 0;
+};
+
+// RegAllocHintStats - hint satisfaction of a function
+class RegAllocHintStats {
+
+  private:
+    const MachineFunction* MF = nullptr;
+    const VirtRegMap* VRM = nullptr;
+    const MachineRegisterInfo* MRI = nullptr;
+    const MachineBlockFrequencyInfo* MBFI = nullptr;
+
+    // vRegs that have had their first assignment
+    BitVector assigned;
+
+    // vRegs with a simple hint at their first assignment, and the ones that got it
+    uint32_t hintedVRegs = 0;
+    uint32_t satisfiedVRegs = 0;
+
+    // tryHintsRecoloring() candidates and the live ranges it recolored
+    uint32_t recoloringCandidates = 0;
+    uint32_t recoloredVRegs = 0;
+
+    // copies before and after tryHintsRecoloring()
+    RegAllocCopyCost beforeRecoloring;
+    RegAllocCopyCost afterRecoloring;
+
+    RegAllocCopyCost measureCopies() const;
+
+  public:
+    // Resets the stats for a new function
+    void clear(const MachineFunction* MF, const VirtRegMap* VRM, const MachineRegisterInfo* MRI,
+               const MachineBlockFrequencyInfo* MBFI);
+
+    bool isTracking() const { return MBFI != nullptr; }
+
+    // selectOrSplit() handed physReg to reg - only its first assignment counts
+    void recordAssignment(Register reg, unsigned physReg);
+
+    void beginRecoloring(unsigned numCandidates) {
+      recoloringCandidates = numCandidates;
+      beforeRecoloring = measureCopies();
+    }
+
+    void recordRecoloring() { recoloredVRegs++; }
+
+    void endRecoloring() { afterRecoloring = measureCopies(); }
+
+    uint32_t getHintedVRegs() const { return hintedVRegs; }
+    uint32_t getSatisfiedVRegs() const { return satisfiedVRegs; }
+    uint32_t getRecoloringCandidates() const { return recoloringCandidates; }
+    uint32_t getRecoloredVRegs() const { return recoloredVRegs; }
+    const RegAllocCopyCost& getCopiesBeforeRecoloring() const { return beforeRecoloring; }
+    const RegAllocCopyCost& getCopiesAfterRecoloring() const { return afterRecoloring; }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCHINTSTATS_H
@@ -0,0 +1,82 @@
+#ifndef LLVM_CODEGEN_REGALLOCINTERFERENCESTATS_H
+#define LLVM_CODEGEN_REGALLOCINTERFERENCESTATS_H
+
+#include "llvm/CodeGen/TargetRegisterInfo.h"
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocInterferenceStats - per-physReg accounting of RAGreedy's interference checks
+//
+//  - LiveRegMatrix::checkInterference() and query() calls from RAGreedy, each with the
+//    LiveIntervalUnion segments its unit queries visited. The segments are counted by
+//    LiveIntervalUnion::Query::collectInterferingVRegs() itself, a call answered from the
+//    query's cached results visits none.
+//  - InterferenceCache::get() lookups, counted by the cache: a hit if the physReg's entry is
+//    up to date, a revalidation if one of its LiveIntervalUnions changed, and otherwise a
+//    miss that resets a round-robin entry - an eviction if that entry held another physReg.
+class RegAllocInterferenceStats {
+
+  public:
+    struct PhysRegCounts {
+      uint64_t checks = 0;
+      // LiveIntervalUnion segments visited by the checks
+      uint64_t checkSegments = 0;
+      uint64_t queries = 0;
+      // LiveIntervalUnion segments visited by the queries
+      uint64_t querySegments = 0;
+      uint64_t cacheHits = 0;
+      uint64_t cacheRevalidations = 0;
+      uint64_t cacheMisses = 0;
+      uint64_t cacheEvictions = 0;
+
+      // nothing was counted for the physReg
+      bool empty() const {
+        return !checks && !queries && !cacheHits && !cacheRevalidations && !cacheMisses;
+      }
+
+      PhysRegCounts& operator+=(const PhysRegCounts& other);
+    };
+
+  private:
+    std::vector<PhysRegCounts> physRegCounts;
+
+  public:
+    // Resets the stats for a new function
+    void clear(const TargetRegisterInfo* TRI) {
+      physRegCounts.assign(TRI->getNumRegs(), PhysRegCounts());
+    }
+
+    bool isTracking() const { return !physRegCounts.empty(); }
+
+    void recordCheckInterference(unsigned physReg, unsigned segmentsVisited) {
+      physRegCounts[physReg].checks++;
+      physRegCounts[physReg].checkSegments += segmentsVisited;
+    }
+
+    void recordQuery(unsigned physReg, unsigned segmentsVisited) {
+      physRegCounts[physReg].queries++;
+      physRegCounts[physReg].querySegments += segmentsVisited;
+    }
+
+    // InterferenceCache::get() lookups
+    void recordCacheHit(unsigned physReg) { physRegCounts[physReg].cacheHits++; }
+
+    void recordCacheRevalidation(unsigned physReg) { physRegCounts[physReg].cacheRevalidations++; }
+
+    // evicted - the entry that was reset held another physReg
+    void recordCacheMiss(unsigned physReg, bool evicted) {
+      physRegCounts[physReg].cacheMisses++;
+      if (evicted)
+        physRegCounts[physReg].cacheEvictions++;
+    }
+
+    unsigned getNumPhysRegs() const { return physRegCounts.size(); }
+
+    const PhysRegCounts& get(unsigned physReg) const { return physRegCounts[physReg]; }
+
+    PhysRegCounts getTotals() const;
+};
+
+#endif // LLVM_CODEGEN_REGALLOCINTERFERENCESTATS_H
@@ -0,0 +1,90 @@
+#ifndef LLVM_CODEGEN_REGALLOCLCRSTATS_H
+#define LLVM_CODEGEN_REGALLOCLCRSTATS_H
+
+#include "llvm/CodeGen/Register.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocLCRInvocation - one outermost RAGreedy::tryLastChanceRecoloring call, nested
+// recoloring attempts are accounted for in the invocation that started them
+struct RegAllocLCRInvocation {
+  enum Flags : uint8_t {
+    // a physReg was found
+    LCR_Succeeded = 1,
+    // the attempt under lowered limits failed on a cutoff and was redone with the full ones
+    LCR_Retried = 2
+  };
+
+  // virtReg index
+  uint32_t vReg;
+  // limits in effect when the invocation started
+  uint32_t depthLimit;
+  uint32_t interferenceLimit;
+  // deepest recursion reached, 0 for the outermost call
+  uint32_t maxDepth;
+  // physRegs tried, over all recursion levels
+  uint32_t candidates;
+  // -lcr-max-depth / -lcr-max-interf cutoffs hit
+  uint32_t depthCutoffs;
+  uint32_t interferenceCutoffs;
+  uint64_t nanos;
+  uint8_t flags;
+};
+
+// RegAllocLCRLimits - an adaptive lowering of the recoloring limits
+struct RegAllocLCRLimits {
+  // invocations before the limits were lowered
+  uint32_t invocations;
+  // recoloring time of the function at that point
+  uint64_t nanos;
+  uint32_t depthLimit;
+  uint32_t interferenceLimit;
+};
+
+// RegAllocLCRStats - last chance recoloring telemetry of a function
+class RegAllocLCRStats {
+
+  private:
+    std::vector<RegAllocLCRInvocation> invocations;
+    std::vector<RegAllocLCRLimits> limitChanges;
+
+    bool inInvocation = false;
+    RegAllocLCRInvocation current;
+
+  public:
+    // Resets the stats for a new function - keeps the storage
+    void clear() {
+      invocations.clear();
+      limitChanges.clear();
+      inInvocation = false;
+    }
+
+    void beginInvocation(Register reg, unsigned depthLimit, unsigned interferenceLimit);
+    void endInvocation(bool succeeded, bool retried, uint64_t nanos);
+
+    void recordDepth(unsigned depth) {
+      if (inInvocation)
+        current.maxDepth = std::max(current.maxDepth, (uint32_t)depth);
+    }
+
+    void recordCandidate() { current.candidates += inInvocation; }
+
+    void recordCutoff(bool depth) {
+      if (!inInvocation)
+        return;
+      if (depth)
+        current.depthCutoffs++;
+      else
+        current.interferenceCutoffs++;
+    }
+
+    void recordLimits(uint64_t nanos, unsigned depthLimit, unsigned interferenceLimit);
+
+    const std::vector<RegAllocLCRInvocation>& getInvocations() const { return invocations; }
+    const std::vector<RegAllocLCRLimits>& getLimitChanges() const { return limitChanges; }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCLCRSTATS_H
@@ -0,0 +1,46 @@
+#ifndef LLVM_CODEGEN_REGALLOCLOOPSPILLSTATS_H
+#define LLVM_CODEGEN_REGALLOCLOOPSPILLSTATS_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocLoopSpills - spill code of a loop, as reported by the "LoopSpillReload" remark of
+// RAGreedy::reportNumberOfSplillsReloads(). Counts include the loop's subloops.
+struct RegAllocLoopSpills {
+  // number of the loop header block
+  uint32_t header;
+  // 1 for outermost loops
+  uint32_t depth;
+  // header block frequency relative to the entry block
+  float freq;
+  uint32_t reloads;
+  uint32_t foldedReloads;
+  uint32_t spills;
+  uint32_t foldedSpills;
+  // MachineLoop::getStartLoc() - line 0 and an empty file without debug info
+  uint32_t line;
+  uint32_t column;
+  StringRef file;
+};
+
+// RegAllocLoopSpillStats - loops of a function that spill code was generated in
+class RegAllocLoopSpillStats {
+
+  private:
+    std::vector<RegAllocLoopSpills> loops;
+
+  public:
+    // Resets the stats for a new function - keeps the storage
+    void clear() { loops.clear(); }
+
+    void record(const MachineLoop& L, float freq, unsigned reloads, unsigned foldedReloads,
+                unsigned spills, unsigned foldedSpills);
+
+    const std::vector<RegAllocLoopSpills>& getLoops() const { return loops; }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCLOOPSPILLSTATS_H
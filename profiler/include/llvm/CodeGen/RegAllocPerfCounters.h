@@ -0,0 +1,84 @@
+#ifndef LLVM_CODEGEN_REGALLOCPERFCOUNTERS_H
+#define LLVM_CODEGEN_REGALLOCPERFCOUNTERS_H
+
+#include <cstdint>
+
+// RegAllocPerfPhase - parts of RAGreedy::runOnMachineFunction the counters are split by
+enum RegAllocPerfPhase : uint8_t {
+  RPP_AllocatePhysRegs,
+  RPP_HintsRecoloring,
+  RPP_PostOptimization,
+  RPP_NumPhases
+};
+
+// RegAllocPerfCounter - hardware events that are counted
+enum RegAllocPerfCounter : uint8_t {
+  RPC_Instructions,
+  RPC_Cycles,
+  // last level cache read misses
+  RPC_LLCMisses,
+  RPC_BranchMisses,
+  RPC_NumCounters
+};
+
+// Names as used in the text output
+const char* getRegAllocPerfPhaseName(RegAllocPerfPhase phase);
+const char* getRegAllocPerfCounterName(RegAllocPerfCounter counter);
+
+// RegAllocPerfCounters - per-function hardware counter readings of the allocator phases
+// The counters are opened once per module with perf_event_open (Linux only) as a single
+// group that counts the calling thread in user space. Every counter that can't be opened -
+// no PMU, perf_event_paranoid, seccomp in containers - is reported as unavailable, and when
+// none can be opened every method is a no-op.
+class RegAllocPerfCounters {
+
+  public:
+    // value of a counter that is not available
+    static const uint64_t Unavailable = ~0ull;
+
+  private:
+    // group leader first, -1 for counters that could not be opened
+    int fds[RPC_NumCounters];
+
+    // position of each counter in the group read, -1 if not in the group
+    int groupIndex[RPC_NumCounters];
+    unsigned groupSize = 0;
+
+    // readings of the current function, accumulated per phase
+    uint64_t totals[RPP_NumPhases][RPC_NumCounters];
+
+    // snapshot taken by beginPhase()
+    uint64_t phaseStart[RPC_NumCounters];
+
+    // Reads the scaled group values into values, returns false if the read failed
+    bool read(uint64_t values[RPC_NumCounters]) const;
+
+  public:
+    RegAllocPerfCounters();
+    ~RegAllocPerfCounters() { close(); }
+
+    RegAllocPerfCounters(const RegAllocPerfCounters&) = delete;
+    RegAllocPerfCounters& operator=(const RegAllocPerfCounters&) = delete;
+
+    // Opens and starts the counters - returns false (and warns once) if none is available
+    bool open();
+
+    void close();
+
+    bool isOpen() const { return groupSize != 0; }
+
+    bool isAvailable(RegAllocPerfCounter counter) const { return groupIndex[counter] >= 0; }
+
+    // Resets the totals for a new function
+    void clear();
+
+    void beginPhase(RegAllocPerfPhase phase);
+    void endPhase(RegAllocPerfPhase phase);
+
+    // Counter total of a phase in the current function, Unavailable if not counted
+    uint64_t get(RegAllocPerfPhase phase, RegAllocPerfCounter counter) const {
+      return isAvailable(counter) ? totals[phase][counter] : Unavailable;
+    }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCPERFCOUNTERS_H
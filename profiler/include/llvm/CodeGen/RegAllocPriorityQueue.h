@@ -0,0 +1,114 @@
+#ifndef LLVM_CODEGEN_REGALLOCPRIORITYQUEUE_H
+#define LLVM_CODEGEN_REGALLOCPRIORITYQUEUE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Implementations of the greedy allocator's work queue, picked with -regalloc-pqueue
+enum RegAllocPriorityQueueKind {
+  // std::priority_queue of (prio, ~reg) pairs, the stock LLVM queue
+  RPQ_BinaryHeap,
+  // RegAllocBucketedQueue
+  RPQ_Bucketed
+};
+
+// RegAllocBucketedQueue - two-level bucketed max queue of (prio, ~reg) entries
+//
+// RAGreedy::enqueue keeps the coarse class of a live range in the top byte of its priority
+// (bits 31, 30, 29 and AllocationPriority << 24) and a size or instruction distance below
+// it. Entries are bucketed by that top byte, a 256 bit mask finds the highest non empty
+// bucket in a few word scans, and each bucket is a binary heap over the packed 64 bit key
+// prio << 32 | ~reg. Within a bucket the key compares exactly like the std::pair did, and
+// buckets partition the key space in order, so entries come out in the same order as from
+// std::priority_queue - ties on prio included - and the allocation is bit-identical.
+// The per bucket heaps stay small, so pushes and pops touch far fewer cache lines.
+// A radix heap would need monotone keys, which splitting and eviction break: both enqueue
+// live ranges of higher priority than the one just dequeued.
+class RegAllocBucketedQueue {
+
+  public:
+    static const unsigned NumBuckets = 256;
+
+  private:
+    static const unsigned NumMaskWords = NumBuckets / 64;
+
+    std::vector<uint64_t> buckets[NumBuckets];
+    uint64_t nonEmpty[NumMaskWords] = {};
+    size_t numEntries = 0;
+
+    // highest non empty bucket, only valid while numEntries != 0
+    unsigned topBucket = 0;
+
+    static uint64_t pack(unsigned prio, unsigned invReg) {
+      return (uint64_t)prio << 32 | invReg;
+    }
+
+    static unsigned bucketOf(unsigned prio) { return prio >> 24; }
+
+    void findTopBucket();
+
+  public:
+    bool empty() const { return numEntries == 0; }
+    size_t size() const { return numEntries; }
+
+    void push(const std::pair<unsigned, unsigned>& entry);
+
+    std::pair<unsigned, unsigned> top() const {
+      assert(numEntries && "top() of an empty queue!");
+      uint64_t key = buckets[topBucket].front();
+      return std::make_pair(unsigned(key >> 32), unsigned(key));
+    }
+
+    void pop();
+};
+
+// RegAllocPriorityQueue - the greedy allocator's work queue, a max queue of (prio, ~reg)
+// pairs with the interface of the std::priority_queue it replaces
+// The implementation is fixed at construction - RAGreedy passes -regalloc-pqueue - so
+// the main queue and the last chance recoloring queues always agree on it. The bucketed
+// queue is only allocated when it is picked: its 256 buckets would otherwise be built and
+// torn down with every recoloring queue of the stock binary heap configuration.
+class RegAllocPriorityQueue {
+
+  private:
+    RegAllocPriorityQueueKind kind;
+    std::priority_queue<std::pair<unsigned, unsigned>> heap;
+    std::unique_ptr<RegAllocBucketedQueue> bucketed;
+
+  public:
+    explicit RegAllocPriorityQueue(RegAllocPriorityQueueKind kind = RPQ_BinaryHeap)
+        : kind(kind) {
+      if (kind == RPQ_Bucketed)
+        bucketed.reset(new RegAllocBucketedQueue());
+    }
+
+    RegAllocPriorityQueueKind getKind() const { return kind; }
+
+    bool empty() const { return kind == RPQ_Bucketed ? bucketed->empty() : heap.empty(); }
+    size_t size() const { return kind == RPQ_Bucketed ? bucketed->size() : heap.size(); }
+
+    void push(const std::pair<unsigned, unsigned>& entry) {
+      if (kind == RPQ_Bucketed)
+        bucketed->push(entry);
+      else
+        heap.push(entry);
+    }
+
+    std::pair<unsigned, unsigned> top() const {
+      return kind == RPQ_Bucketed ? bucketed->top() : heap.top();
+    }
+
+    void pop() {
+      if (kind == RPQ_Bucketed)
+        bucketed->pop();
+      else
+        heap.pop();
+    }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCPRIORITYQUEUE_H
@@ -1,4 +1,10 @@
+#ifndef LLVM_CODEGEN_REGALLOCPROFILER_H
+#define LLVM_CODEGEN_REGALLOCPROFILER_H
+
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/IndexedMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/CodeGen/Register.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineOperand.h"
@@ -21,10 +27,105 @@
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/LiveIntervals.h"
+#include "llvm/CodeGen/RegAllocCSRStats.h"
+#include "llvm/CodeGen/RegAllocEventRing.h"
+#include "llvm/CodeGen/RegAllocEvictionGraph.h"
+#include "llvm/CodeGen/RegAllocHintStats.h"
+#include "llvm/CodeGen/RegAllocInterferenceStats.h"
+#include "llvm/CodeGen/RegAllocLCRStats.h"
+#include "llvm/CodeGen/RegAllocLoopSpillStats.h"
+#include "llvm/CodeGen/RegAllocPerfCounters.h"
+#include "llvm/CodeGen/RegAllocQueueStats.h"
+#include "llvm/CodeGen/RegAllocRegionSplitStats.h"
+#include "llvm/CodeGen/RegAllocSpillCost.h"
+#include "llvm/CodeGen/RegAllocSplitTree.h"
+#include "llvm/CodeGen/RegAllocTrace.h"
+#include "llvm/Support/raw_ostream.h"
 #include "set"
+#include <memory>
 
 using namespace llvm;
 
+namespace llvm {
+class InterferenceCache;
+}
+
+// VRegBitSet - growable set of virtRegs, one bit per virtReg index
+// Cheap enough to be updated on the allocator's hot path: insert/contains are a bit
+// operation, and clear() keeps the storage around for the next function
+class VRegBitSet {
+
+  private:
+    BitVector bits;
+
+  public:
+    // Makes room for numVirtRegs vRegs up front so inserts don't have to grow
+    void reserve(unsigned numVirtRegs) {
+      if (bits.size() < numVirtRegs)
+        bits.resize(numVirtRegs);
+    }
+
+    void clear() { bits.reset(); }
+
+    void insert(Register reg) {
+      unsigned idx = Register::virtReg2Index(reg);
+      if (idx >= bits.size())
+        bits.resize(idx + 1);
+      bits.set(idx);
+    }
+
+    bool contains(Register reg) const {
+      unsigned idx = Register::virtReg2Index(reg);
+      return idx < bits.size() && bits.test(idx);
+    }
+
+    unsigned count() const { return bits.count(); }
+};
+
+// RegAllocProfilerSink - module-lifetime output file for the profiler
+// The allocator opens it once per module, every function appends its records to an
+// in-memory buffer, and the buffer is written out in large blocks once it grows past
+// the flush threshold (and on close). Records never straddle two writes, so several
+// llc processes can append to the same file.
+class RegAllocProfilerSink {
+
+  private:
+    // output file, null when the sink is closed or could not be opened
+    std::unique_ptr<raw_fd_ostream> out;
+
+    // pending records that have not been written to the file yet
+    SmallVector<char, 0> buffer;
+    raw_svector_ostream bufferStream;
+
+    // number of buffered bytes that triggers a write to the file
+    size_t flushThreshold;
+
+  public:
+    RegAllocProfilerSink() : bufferStream(buffer), flushThreshold(0) {}
+    ~RegAllocProfilerSink() { close(); }
+
+    // Opens fname in append mode - returns false (and warns) if it can't be opened
+    bool open(StringRef fname, size_t flushThreshold);
+
+    // Flushes everything still buffered and closes the file
+    void close();
+
+    bool isOpen() const { return out != nullptr; }
+
+    // Stream the current record is written to - call endRecord() once it is complete
+    raw_ostream& record() { return bufferStream; }
+
+    // Marks the end of a record, writes the buffer out if it passed the flush threshold
+    void endRecord() {
+      if (buffer.size() >= flushThreshold)
+        flush();
+    }
+
+    // Writes all buffered records to the file
+    void flush();
+};
+
 // RegAllocProfiler - parses VRM & MRI data to collect Register Allocation performance statistics
 // i.e number of virtual registers allocated to physical registers, stack slots, etc
 // TODO: Add more detailed info about performance stats
@@ -54,6 +155,9 @@ class RegAllocProfiler {
     // Useful for getting more in-depth virtReg info
     MachineRegisterInfo* MRI; 
 
+    // To get the live interval size/spill weight of the original virtRegs
+    LiveIntervals* LIS;
+
     // VRegInfo - copy of the VRegInfo stored in MRI, useful to keep a local copy
     // Holds information about VReg register class and use/defs in machine instructions
     const IndexedMap<std::pair<RegClassOrRegBank, MachineOperand*>,
@@ -64,50 +168,92 @@ class RegAllocProfiler {
     // Contains info about virtReg->physReg mappings
     const IndexedMap<Register, VirtReg2IndexFunctor>& regMap; 
 
-    // stackSlotMap - Map holding spill data from VRM 
-    const IndexedMap<int, VirtReg2IndexFunctor> stackSlotMap; 
-
-
     // Containers to hold references for all allocated/spilled vars
     std::vector<Register> allocatedVRegs; 
     std::vector<Register> spilledVRegs;
 
-    // get all vregClassData
-    std::map<std::string, std::vector<Register>> vRegClassData;
+    // Number of register class buckets - one per TargetRegisterClass ID, plus a trailing
+    // bucket for vRegs that only carry a register bank (reported with an empty class name)
+    unsigned numClassBuckets;
 
-    // registerNameMap - maps all the individual phys reg names to the virtual registers assigned to them
-    // map[register_name] ---> {all virtRegs allocated to this register}
-    struct regNameMap {
-      std::map<StringRef, std::vector<unsigned>> nmap; 
-    };
+    // classNumVRegs[classID] -> number of original vRegs (allocated or spilled) in the class
+    SmallVector<unsigned, 32> classNumVRegs;
 
-    // RegClassMap - a nested map that holds mapping information for each register class
-    // Basically lists all virtual registers mapped to a specific register class 
-    // map[class_name] ---> (regNameMap) 
-    std::map<std::string, regNameMap> regClassMap; 
+    // classAllocBegin[classID] .. classAllocBegin[classID+1] is the slice of classAllocVRegs
+    // holding every allocated vReg of that class, i.e. the old regClassMap flattened into
+    // one array bucketed by register class ID
+    SmallVector<unsigned, 32> classAllocBegin;
+    std::vector<Register> classAllocVRegs;
 
-    // Another quick map holding data relating a reg class to the number of unique registers allocated within it
-    // and the total number of virtRegs allocated to ti
-    // map[class_name] ---> (numUniqueRegsAllocated, totalVirtRegsAllocated)
-    std::map<StringRef, std::pair<unsigned, unsigned>> regClassData;
+    // classUniquePhysRegs[classID] -> number of distinct physRegs handed out within the class
+    SmallVector<unsigned, 32> classUniquePhysRegs;
 
+    // physRegStamp[physReg] -> (classID + 1) of the last class that counted this physReg
+    // Lets calculateProfilerStats() count unique physRegs per class without a set
+    std::vector<unsigned> physRegStamp;
 
     // Vector containing the set of all the originally enqueued virtRegs
     std::vector<Register> originalVRegSet;
 
+    // Live interval size & spill weight of each originalVRegSet entry (same order)
+    // Captured while seeding since splitting/spilling replaces the original intervals
+    std::vector<unsigned> origVRegSize;
+    std::vector<float> origVRegWeight;
+
     // origVRegInfo -> contains allocation status for the all non-dbg virtual registers that were originally enqueued at the 
     // start of regalloc. Designed to exclude virtRegs created by splitting & spilling.
-    // Each vReg is mapped to a binary encoding ->  1 for physReg allocation, 0  for stack slot assignment
-    std::map<Register, bool> origVRegInfo;
-
+    // Indexed by virtReg index, 1 for physReg allocation, 0  for stack slot assignment
+    BitVector origVRegInfo;
 
     // 11/10 - added DS for all split-marked vRegs 
-    std::set<Register>* splitMarkedVRegs;
-  
-    // Determines the original virtual register set in the MachineFunction
-    // before splitting/spilling
-    void getOriginalVRegs(); 
+    // read-only view of the set the allocator updates
+    const VRegBitSet& splitMarkedVRegs;
+
+    // allocator events of this function, null if none were recorded
+    const RegAllocEventRing* events = nullptr;
+
+    // hardware counters of this function's allocator phases, null if not collected
+    const RegAllocPerfCounters* perfCounters = nullptr;
+
+    // evictions of this function, null if they were not recorded
+    const RegAllocEvictionGraph* evictions = nullptr;
+
+    // work queue telemetry of this function, null if it was not recorded
+    const RegAllocQueueStats* queueStats = nullptr;
+
+    // interference check accounting of this function, null if it was not tracked
+    const RegAllocInterferenceStats* interferenceStats = nullptr;
+
+    // global region split cost accounting of this function, null if it was not recorded
+    const RegAllocRegionSplitStats* regionSplitStats = nullptr;
+
+    // last chance recoloring telemetry of this function, null if it was not recorded
+    const RegAllocLCRStats* lcrStats = nullptr;
+
+    // frequency weighted spill code of this function, null if it was not measured
+    const RegAllocSpillCostStats* spillCost = nullptr;
+
+    // loops of this function with spill code, null if they were not recorded
+    const RegAllocLoopSpillStats* loopSpills = nullptr;
+
+    // split provenance of this function's original vRegs, null if it was not recorded
+    const RegAllocSplitTree* splitTree = nullptr;
+
+    // hint satisfaction of this function, null if it was not recorded
+    const RegAllocHintStats* hintStats = nullptr;
+
+    // callee-saved register first use decisions of this function, null if not recorded
+    const RegAllocCSRStats* csrStats = nullptr;
 
+    // row of this function in the current trace chunk's "functions" table
+    uint32_t traceFunctionRow = 0;
+
+    // Maps a virtReg to its register class bucket
+    unsigned getRegClassID(Register reg);
+
+    // Gets the name of a register class bucket
+    StringRef getRegClassBucketName(unsigned classID);
+  
     // populates the regClassMap by parsing each virtual register and 
     // adding it to the mapped name register
     void populateRegisterClassMap();
@@ -121,15 +267,26 @@ class RegAllocProfiler {
                       const TargetRegisterInfo* TRI, 
                       VirtRegMap* VRM, 
                       MachineRegisterInfo* MRI,
-                      std::set<Register>* splitMarkedVRegs);
+                      LiveIntervals* LIS,
+                      const VRegBitSet& splitMarkedVRegs);
                        
     // Quick Accessor method for originalVRegs
     std::vector<Register> originalVRegs() { return originalVRegSet; }
 
+    // Name of the function being profiled
+    StringRef getFunctionName() const { return MF->getName(); }
+
     // IMPORTANT: this needs to be called BEFORE allocatePhysRegs() in the RA 
-    // MRI dynamically increases because of spilled virtRegs - call this function before
-    // allocatePhysRegs() in order to accurately get the original vreg set
+    // MRI dynamically increases because of spilled virtRegs - the original vReg set is
+    // then recorded through addOriginalVReg() while seedLiveRegs() enqueues it
     void init();
+
+    // Records a vReg of the original set, i.e. one enqueued by seedLiveRegs()
+    void addOriginalVReg(const LiveInterval& LI) {
+      originalVRegSet.push_back(LI.reg);
+      origVRegSize.push_back(LI.getSize());
+      origVRegWeight.push_back(LI.weight);
+    }
      
     // Has to be called after allocatePhysRegs() in order to accurately compute
     // RA statistics
@@ -170,10 +327,420 @@ class RegAllocProfiler {
     // writes debug stats to file - I'll implement file I/O later
     void writeDebugStats(MachineFunction& MF); 
     
-    // Dump profiler stats to file
-    void dumpProfStatsToFile(std::string fname);
+    // Writes the per-function profiler stats record
+    void writeProfStats(raw_ostream& os);
+
+    // Dump profiler stats to the module's output sink
+    void dumpProfStatsToSink(RegAllocProfilerSink& sink);
+
+    // Appends the function counters and a record per original vReg to the binary trace
+    void dumpProfStatsToTrace(RegAllocTraceWriter& trace);
+
+    // Attaches the allocator events of this function - they are reported by the dump methods
+    void attachEvents(const RegAllocEventRing& ring) { events = &ring; }
+
+    // Attaches the hardware counter readings of this function
+    void attachPerfCounters(const RegAllocPerfCounters& counters) { perfCounters = &counters; }
+
+    // Attaches the eviction graph of this function
+    void attachEvictions(const RegAllocEvictionGraph& graph) { evictions = &graph; }
+
+    // Attaches the work queue telemetry of this function
+    void attachQueueStats(const RegAllocQueueStats& stats) { queueStats = &stats; }
+
+    // Attaches the interference check accounting of this function
+    void attachInterferenceStats(const RegAllocInterferenceStats& stats) { interferenceStats = &stats; }
+
+    // Attaches the global region split cost accounting of this function
+    void attachRegionSplitStats(const RegAllocRegionSplitStats& stats) { regionSplitStats = &stats; }
+
+    // Attaches the last chance recoloring telemetry of this function
+    void attachLCRStats(const RegAllocLCRStats& stats) { lcrStats = &stats; }
+
+    // Attaches the frequency weighted spill code of this function
+    void attachSpillCost(const RegAllocSpillCostStats& stats) { spillCost = &stats; }
+
+    // Attaches the loops of this function with spill code
+    void attachLoopSpills(const RegAllocLoopSpillStats& stats) { loopSpills = &stats; }
+
+    // Attaches the split provenance of this function's original vRegs
+    void attachSplitTree(const RegAllocSplitTree& tree) { splitTree = &tree; }
+
+    // Attaches the hint satisfaction of this function
+    void attachHintStats(const RegAllocHintStats& stats) { hintStats = &stats; }
+
+    // Attaches the callee-saved register first use decisions of this function
+    void attachCSRStats(const RegAllocCSRStats& stats) { csrStats = &stats; }
     
     // dumps all regalloc statistics, and everything in the registerNameMap
     void dump();
 };
 
+
+// Compile-time switch for the profiler hooks in the greedy allocator. Building with
+// -DLLVM_REGALLOC_PROFILER=0 (cmake -DLLVM_ENABLE_REGALLOC_PROFILER=OFF) swaps in the
+// disabled hooks, whose empty inline bodies leave nothing behind in RAGreedy.
+#ifndef LLVM_REGALLOC_PROFILER
+#define LLVM_REGALLOC_PROFILER 1
+#endif
+
+// RegAllocProfilerHooks - the allocator's only entry points into the profiler
+// Owns everything that lives across functions (split-marked vRegs, output sink, trace)
+template <bool Enabled> class RegAllocProfilerHooks;
+
+template <> class RegAllocProfilerHooks<false> {
+  public:
+    void beginModule(bool, StringRef, StringRef, size_t, bool) {}
+    void endModule() {}
+    void beginFunction(MachineFunction*, const TargetRegisterInfo*, VirtRegMap*,
+                       MachineRegisterInfo*, LiveIntervals*) {}
+    void seedVReg(const LiveInterval&) {}
+    void endFunction() {}
+    void markSplit(Register) {}
+    void recordEvent(RegAllocEventKind, const LiveInterval&, unsigned, unsigned) {}
+    void beginPhase(RegAllocPerfPhase) {}
+    void endPhase(RegAllocPerfPhase) {}
+    void recordEviction(const LiveInterval&, const LiveInterval&, unsigned, unsigned, unsigned,
+                        float) {}
+    void recordEnqueue(size_t) {}
+    void recordDequeue(Register, unsigned, size_t) {}
+    void recordDroppedUnused() {}
+    void recordStageTransition(unsigned, unsigned) {}
+    void trackInterference(const TargetRegisterInfo*, InterferenceCache&) {}
+    bool isTrackingInterference() const { return false; }
+    void recordCheckInterference(unsigned, unsigned) {}
+    void recordQuery(unsigned, unsigned) {}
+    void beginRegionSplit(const LiveInterval&, unsigned, uint64_t) {}
+    void endRegionSplit(uint64_t, bool, bool) {}
+    void recordSplitCandidate() {}
+    void recordGrowIteration() {}
+    void recordBundlesActivated(unsigned) {}
+    void beginSpillPlacement() {}
+    void endSpillPlacement() {}
+    void beginLastChanceRecoloring(const LiveInterval&, unsigned, unsigned) {}
+    void endLastChanceRecoloring(bool, bool, uint64_t) {}
+    void recordLCRDepth(unsigned) {}
+    void recordLCRCandidate() {}
+    void recordLCRCutoff(bool) {}
+    void recordLCRLimits(uint64_t, unsigned, unsigned) {}
+    void trackSpillCost(const MachineFunction*, const VirtRegMap*, const MachineRegisterInfo*,
+                        const MachineBlockFrequencyInfo*, bool) {}
+    void forgetInstruction(const MachineInstr*) {}
+    void recordLoopSpills(const MachineLoop&, float, unsigned, unsigned, unsigned, unsigned) {}
+    void recordSplit(RegAllocSplitKind, const LiveInterval&, ArrayRef<unsigned>) {}
+    void recordSpill(const LiveInterval&, ArrayRef<unsigned>) {}
+    void recordClone(unsigned, unsigned) {}
+    void trackHints(const MachineFunction*, const VirtRegMap*, const MachineRegisterInfo*,
+                    const MachineBlockFrequencyInfo*) {}
+    void recordAssignment(const LiveInterval&, unsigned) {}
+    void beginHintsRecoloring(unsigned) {}
+    void recordHintRecoloring() {}
+    void endHintsRecoloring() {}
+    void trackCSRCost(uint64_t) {}
+    void recordCSRDecision(const LiveInterval&, unsigned, unsigned, RegAllocCSRDecision::Alternative,
+                           uint64_t, RegAllocCSRDecision::Outcome) {}
+    void countUsedCSRs(const MachineRegisterInfo*, const LiveRegMatrix*) {}
+};
+
+template <> class RegAllocProfilerHooks<true> {
+
+  private:
+    // set by beginModule() from -regalloc-profile, every hook is a no-op without it
+    bool enabled = false;
+
+    // split-marked vRegs of the current function
+    VRegBitSet splitMarkedVRegs;
+
+    // Module-lifetime output file shared by the per-function profilers
+    RegAllocProfilerSink sink;
+
+    // Module-lifetime binary trace, only open with -regalloc-profile-trace
+    RegAllocTraceWriter trace;
+
+    // profiler of the function currently being allocated
+    std::unique_ptr<RegAllocProfiler> profiler;
+
+    // allocator decisions of the current function
+    RegAllocEventRing events;
+
+    // hardware counters, only open with -regalloc-profile-perf-counters
+    RegAllocPerfCounters perfCounters;
+
+    // evictor -> evictee edges of the current function
+    RegAllocEvictionGraph evictions;
+
+    // work queue telemetry of the current function
+    RegAllocQueueStats queueStats;
+
+    // interference check accounting of the current function
+    RegAllocInterferenceStats interferenceStats;
+
+    // global region split cost accounting of the current function
+    RegAllocRegionSplitStats regionSplitStats;
+
+    // last chance recoloring telemetry of the current function
+    RegAllocLCRStats lcrStats;
+
+    // frequency weighted spill code of the current function
+    RegAllocSpillCostStats spillCost;
+
+    // loops of the current function with spill code
+    RegAllocLoopSpillStats loopSpills;
+
+    // split provenance of the current function's original vRegs
+    RegAllocSplitTree splitTree;
+
+    // hint satisfaction of the current function
+    RegAllocHintStats hintStats;
+
+    // callee-saved register first use decisions of the current function
+    RegAllocCSRStats csrStats;
+
+  public:
+    // Opens the output files (and the perf counters) when profiling is enabled
+    void beginModule(bool enable, StringRef profileFile, StringRef traceFile, size_t bufferSize,
+                     bool countPerfEvents);
+
+    // Flushes and closes the output files
+    void endModule();
+
+    // IMPORTANT: this needs to be called BEFORE allocatePhysRegs() - see RegAllocProfiler::init()
+    void beginFunction(MachineFunction* MF, const TargetRegisterInfo* TRI, VirtRegMap* VRM,
+                       MachineRegisterInfo* MRI, LiveIntervals* LIS);
+
+    // Called from RegAllocBase::seededLiveReg() for each original vReg
+    void seedVReg(const LiveInterval& LI) {
+      if (!profiler)
+        return;
+      profiler->addOriginalVReg(LI);
+      spillCost.addOriginalVReg(LI.reg);
+      splitTree.addOriginal(LI);
+    }
+
+    // Computes the stats of the current function and writes them out
+    void endFunction();
+
+    // Records a vReg that was sent back to the queue as RS_Split
+    void markSplit(Register reg) {
+      if (enabled)
+        splitMarkedVRegs.insert(reg);
+    }
+
+    // Records an allocator decision in the event ring
+    void recordEvent(RegAllocEventKind kind, const LiveInterval& VirtReg, unsigned physReg,
+                     unsigned stage) {
+      if (enabled)
+        events.record(kind, VirtReg, physReg, stage);
+    }
+
+    // Records that evictor took physReg from evictee at the given EvictionCost
+    void recordEviction(const LiveInterval& evictor, const LiveInterval& evictee, unsigned physReg,
+                        unsigned cascade, unsigned brokenHints, float maxWeight) {
+      if (enabled)
+        evictions.record(evictor.reg, evictee.reg, physReg, cascade, brokenHints, maxWeight);
+    }
+
+    // Work queue telemetry - depth is the queue size after the enqueue / before the dequeue
+    void recordEnqueue(size_t depth) {
+      if (enabled)
+        queueStats.recordEnqueue(depth);
+    }
+
+    void recordDequeue(Register orig, unsigned stage, size_t depth) {
+      if (enabled)
+        queueStats.recordDequeue(orig, stage, depth);
+    }
+
+    void recordDroppedUnused() {
+      if (enabled)
+        queueStats.recordDroppedUnused();
+    }
+
+    void recordStageTransition(unsigned from, unsigned to) {
+      if (enabled)
+        queueStats.recordTransition(from, to);
+    }
+
+    // Starts the interference accounting of the current function and hooks it into
+    // cache's lookups - call after InterferenceCache::init()
+    void trackInterference(const TargetRegisterInfo* TRI, InterferenceCache& cache);
+
+    // Whether the interference checks are counted - lets the allocator skip collecting
+    // what it would pass to the record methods
+    bool isTrackingInterference() const { return enabled && interferenceStats.isTracking(); }
+
+    // segmentsVisited - LiveIntervalUnion segments the check's unit queries visited
+    void recordCheckInterference(unsigned physReg, unsigned segmentsVisited) {
+      if (enabled)
+        interferenceStats.recordCheckInterference(physReg, segmentsVisited);
+    }
+
+    // segmentsVisited - LiveIntervalUnion segments the query visited
+    void recordQuery(unsigned physReg, unsigned segmentsVisited) {
+      if (enabled)
+        interferenceStats.recordQuery(physReg, segmentsVisited);
+    }
+
+    // Global region split accounting - a tryRegionSplit attempt is bracketed by
+    // begin/endRegionSplit, costs are block frequencies
+    void beginRegionSplit(const LiveInterval& VirtReg, unsigned throughBlocks, uint64_t spillCost) {
+      if (enabled)
+        regionSplitStats.beginSplit(VirtReg.reg, VirtReg.getSize(), throughBlocks, spillCost);
+    }
+
+    void endRegionSplit(uint64_t bestCost, bool compact, bool foundCandidate) {
+      if (enabled)
+        regionSplitStats.endSplit(bestCost, compact, foundCandidate);
+    }
+
+    void recordSplitCandidate() {
+      if (enabled)
+        regionSplitStats.recordCandidate();
+    }
+
+    void recordGrowIteration() {
+      if (enabled)
+        regionSplitStats.recordGrowIteration();
+    }
+
+    void recordBundlesActivated(unsigned count) {
+      if (enabled)
+        regionSplitStats.recordBundlesActivated(count);
+    }
+
+    // Bracket RAGreedy::growRegion
+    void beginSpillPlacement() {
+      if (enabled)
+        regionSplitStats.beginSolve();
+    }
+
+    void endSpillPlacement() {
+      if (enabled)
+        regionSplitStats.endSolve();
+    }
+
+    // Last chance recoloring - an outermost tryLastChanceRecoloring call is bracketed by
+    // begin/endLastChanceRecoloring, the record calls in between include the nested ones
+    void beginLastChanceRecoloring(const LiveInterval& VirtReg, unsigned depthLimit,
+                                   unsigned interferenceLimit) {
+      if (enabled)
+        lcrStats.beginInvocation(VirtReg.reg, depthLimit, interferenceLimit);
+    }
+
+    void endLastChanceRecoloring(bool succeeded, bool retried, uint64_t nanos) {
+      if (enabled)
+        lcrStats.endInvocation(succeeded, retried, nanos);
+    }
+
+    void recordLCRDepth(unsigned depth) {
+      if (enabled)
+        lcrStats.recordDepth(depth);
+    }
+
+    void recordLCRCandidate() {
+      if (enabled)
+        lcrStats.recordCandidate();
+    }
+
+    // depth is true for a -lcr-max-depth cutoff, false for a -lcr-max-interf one
+    void recordLCRCutoff(bool depth) {
+      if (enabled)
+        lcrStats.recordCutoff(depth);
+    }
+
+    // Measures the spill code of the current function weighted by MBFI once it is allocated,
+    // priceCycles also prices it with the subtarget's scheduling model
+    void trackSpillCost(const MachineFunction* MF, const VirtRegMap* VRM,
+                        const MachineRegisterInfo* MRI, const MachineBlockFrequencyInfo* MBFI,
+                        bool priceCycles);
+
+    // LiveRangeEdit is about to erase MI
+    void forgetInstruction(const MachineInstr* MI) {
+      if (enabled)
+        spillCost.forgetInstruction(MI);
+    }
+
+    // Spill code counted by RAGreedy::reportNumberOfSplillsReloads() for loop L, freq is the
+    // header block frequency relative to the entry block
+    void recordLoopSpills(const MachineLoop& L, float freq, unsigned reloads,
+                          unsigned foldedReloads, unsigned spills, unsigned foldedSpills) {
+      if (enabled)
+        loopSpills.record(L, freq, reloads, foldedReloads, spills, foldedSpills);
+    }
+
+    // Split provenance - VirtReg was split into children, or spilled leaving the spiller's
+    // new vRegs behind
+    void recordSplit(RegAllocSplitKind kind, const LiveInterval& VirtReg,
+                     ArrayRef<unsigned> children) {
+      if (enabled)
+        splitTree.recordSplit(kind, VirtReg.reg, children);
+    }
+
+    void recordSpill(const LiveInterval& VirtReg, ArrayRef<unsigned> products) {
+      if (enabled)
+        splitTree.recordSpill(VirtReg.reg, products);
+    }
+
+    // Dead code elimination separated a connected component of reg into clone
+    void recordClone(unsigned clone, unsigned reg) {
+      if (enabled)
+        splitTree.recordClone(clone, reg);
+    }
+
+    // Tracks hint satisfaction and the copies left behind, weighted by MBFI
+    void trackHints(const MachineFunction* MF, const VirtRegMap* VRM,
+                    const MachineRegisterInfo* MRI, const MachineBlockFrequencyInfo* MBFI);
+
+    // selectOrSplit() assigned physReg to VirtReg
+    void recordAssignment(const LiveInterval& VirtReg, unsigned physReg) {
+      if (enabled)
+        hintStats.recordAssignment(VirtReg.reg, physReg);
+    }
+
+    // Bracket RAGreedy::tryHintsRecoloring, numCandidates is the size of SetOfBrokenHints
+    void beginHintsRecoloring(unsigned numCandidates) {
+      if (enabled)
+        hintStats.beginRecoloring(numCandidates);
+    }
+
+    void recordHintRecoloring() {
+      if (enabled)
+        hintStats.recordRecoloring();
+    }
+
+    void endHintsRecoloring() {
+      if (enabled)
+        hintStats.endRecoloring();
+    }
+
+    // Callee-saved registers - csrCost is the function's CSR first use cost (block frequency)
+    void trackCSRCost(uint64_t csrCost);
+
+    // RAGreedy::tryAssignCSRFirstTime weighed CSR physReg for VirtReg against alternative
+    void recordCSRDecision(const LiveInterval& VirtReg, unsigned physReg, unsigned stage,
+                           RegAllocCSRDecision::Alternative alternative, uint64_t altCost,
+                           RegAllocCSRDecision::Outcome outcome) {
+      if (enabled)
+        csrStats.recordDecision(VirtReg.reg, physReg, stage, alternative, altCost, outcome);
+    }
+
+    // Call once allocation is done
+    void countUsedCSRs(const MachineRegisterInfo* MRI, const LiveRegMatrix* Matrix) {
+      if (enabled)
+        csrStats.countUsedCSRs(*MRI, *Matrix);
+    }
+
+    // The allocator lowered its recoloring limits after nanos of recoloring
+    void recordLCRLimits(uint64_t nanos, unsigned depthLimit, unsigned interferenceLimit) {
+      if (enabled)
+        lcrStats.recordLimits(nanos, depthLimit, interferenceLimit);
+    }
+
+    // Bracket an allocator phase for the hardware counters
+    void beginPhase(RegAllocPerfPhase phase) { perfCounters.beginPhase(phase); }
+    void endPhase(RegAllocPerfPhase phase) { perfCounters.endPhase(phase); }
+};
+
+using DefaultRegAllocProfilerHooks = RegAllocProfilerHooks<LLVM_REGALLOC_PROFILER != 0>;
+
+#endif // LLVM_CODEGEN_REGALLOCPROFILER_H
@@ -0,0 +1,95 @@
+#ifndef LLVM_CODEGEN_REGALLOCQUEUESTATS_H
+#define LLVM_CODEGEN_REGALLOCQUEUESTATS_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/CodeGen/Register.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocQueueStats - telemetry of the greedy allocator's work queue
+// Covers the main queue only (RAGreedy::enqueue/dequeue), the local queues of last chance
+// and hint recoloring are not counted. Stages are RAGreedy::LiveRangeStage values.
+class RegAllocQueueStats {
+
+  public:
+    // RS_New ... RS_Done
+    static const unsigned NumStages = 7;
+
+  private:
+    uint64_t numEnqueues = 0;
+    uint64_t numDequeues = 0;
+
+    // "Dropping unused" in RegAllocBase::allocatePhysRegs
+    uint64_t numDroppedUnused = 0;
+
+    // queue depth right before every dequeue, in dequeue order
+    std::vector<uint32_t> depthSamples;
+    uint32_t maxDepth = 0;
+
+    // dequeues per original vReg index - split products count for their original
+    std::vector<uint32_t> origDequeues;
+
+    // dequeues by the stage of the dequeued vReg
+    uint64_t stageDequeues[NumStages];
+
+    // transitions[from][to]
+    uint64_t transitions[NumStages][NumStages];
+
+  public:
+    RegAllocQueueStats() { clear(0); }
+
+    // Resets the stats for a function with numVirtRegs original vRegs - keeps the storage
+    void clear(unsigned numVirtRegs);
+
+    void recordEnqueue(size_t depth) {
+      numEnqueues++;
+      maxDepth = std::max(maxDepth, (uint32_t)depth);
+    }
+
+    // depth is the queue size before the dequeue
+    void recordDequeue(Register orig, unsigned stage, size_t depth) {
+      numDequeues++;
+      depthSamples.push_back(depth);
+      stageDequeues[stage]++;
+
+      unsigned index = Register::virtReg2Index(orig);
+      if (index >= origDequeues.size())
+        origDequeues.resize(index + 1, 0);
+      origDequeues[index]++;
+    }
+
+    void recordDroppedUnused() { numDroppedUnused++; }
+
+    void recordTransition(unsigned from, unsigned to) {
+      if (from != to)
+        transitions[from][to]++;
+    }
+
+    uint64_t getNumEnqueues() const { return numEnqueues; }
+    uint64_t getNumDequeues() const { return numDequeues; }
+    uint64_t getNumDroppedUnused() const { return numDroppedUnused; }
+    uint32_t getMaxDepth() const { return maxDepth; }
+    double getMeanDepth() const;
+    const std::vector<uint32_t>& getDepthSamples() const { return depthSamples; }
+
+    uint32_t getOrigDequeues(Register orig) const {
+      unsigned index = Register::virtReg2Index(orig);
+      return index < origDequeues.size() ? origDequeues[index] : 0;
+    }
+
+    uint64_t getStageDequeues(unsigned stage) const { return stageDequeues[stage]; }
+    uint64_t getTransitions(unsigned from, unsigned to) const { return transitions[from][to]; }
+
+    // Number of origVRegs dequeued [2^(i-1), 2^i) times for bucket i >= 1, bucket 0 holds
+    // the ones never dequeued
+    void getOrigDequeueHistogram(ArrayRef<Register> origVRegs,
+                                 std::vector<uint32_t>& histogram) const;
+};
+
+// Name of a RAGreedy::LiveRangeStage value as used in the text output
+const char* getRegAllocStageName(unsigned stage);
+
+#endif // LLVM_CODEGEN_REGALLOCQUEUESTATS_H
@@ -0,0 +1,97 @@
+#ifndef LLVM_CODEGEN_REGALLOCREGIONSPLITSTATS_H
+#define LLVM_CODEGEN_REGALLOCREGIONSPLITSTATS_H
+
+#include "llvm/CodeGen/Register.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// RegAllocRegionSplit - cost accounting of one RAGreedy::tryRegionSplit attempt
+struct RegAllocRegionSplit {
+  enum Flags : uint8_t {
+    // calcCompactRegion found a compact region candidate
+    RSF_Compact = 1,
+    // calculateRegionSplitCost found a candidate cheaper than bestCost's start value
+    RSF_FoundCandidate = 2
+  };
+
+  // virtReg index, its live interval size and number of live-through blocks
+  uint32_t vReg;
+  uint32_t size;
+  uint32_t throughBlocks;
+  // GlobalCand entries that were set up, compact region included
+  uint32_t candidates;
+  // SpillPlacer->iterate() calls in growRegion
+  uint32_t growIterations;
+  // live bundles of the candidates that made it through SpillPlacer->finish()
+  uint32_t bundlesActivated;
+  // wall time spent in growRegion, i.e. solving the spill placement
+  uint64_t solveNanos;
+  // block frequencies - the margin is spillCost - bestCost
+  uint64_t spillCost;
+  uint64_t bestCost;
+  uint8_t flags;
+};
+
+// RegAllocRegionSplitStats - global region split cost accounting of a function
+// Candidates, iterations, bundles and solve time are counted for every
+// calculateRegionSplitCost call; the ones within tryRegionSplit also go into that
+// attempt's record.
+class RegAllocRegionSplitStats {
+
+  private:
+    std::vector<RegAllocRegionSplit> splits;
+
+    // the tryRegionSplit attempt in progress
+    bool inSplit = false;
+    RegAllocRegionSplit current;
+
+    // all calculateRegionSplitCost calls, tryAssignCSRFirstTime's included
+    RegAllocRegionSplit totals;
+
+    std::chrono::steady_clock::time_point solveStart;
+
+  public:
+    RegAllocRegionSplitStats() { clear(); }
+
+    // Resets the stats for a new function - keeps the storage
+    void clear();
+
+    void beginSplit(Register reg, unsigned size, unsigned throughBlocks, uint64_t spillCost);
+    void endSplit(uint64_t bestCost, bool compact, bool foundCandidate);
+
+    void recordCandidate() {
+      totals.candidates++;
+      current.candidates += inSplit;
+    }
+
+    void recordGrowIteration() {
+      totals.growIterations++;
+      current.growIterations += inSplit;
+    }
+
+    void recordBundlesActivated(unsigned count) {
+      totals.bundlesActivated += count;
+      if (inSplit)
+        current.bundlesActivated += count;
+    }
+
+    void beginSolve() { solveStart = std::chrono::steady_clock::now(); }
+
+    void endSolve() {
+      uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - solveStart).count();
+      totals.solveNanos += nanos;
+      if (inSplit)
+        current.solveNanos += nanos;
+    }
+
+    const std::vector<RegAllocRegionSplit>& getSplits() const { return splits; }
+
+    // only candidates, growIterations, bundlesActivated and solveNanos are meaningful
+    const RegAllocRegionSplit& getTotals() const { return totals; }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCREGIONSPLITSTATS_H
@@ -0,0 +1,130 @@
+#ifndef LLVM_CODEGEN_REGALLOCSPILLCOST_H
+#define LLVM_CODEGEN_REGALLOCSPILLCOST_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/Register.h"
+#include "llvm/CodeGen/TargetSchedule.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// Kinds of spill code, in the precedence RAGreedy::reportNumberOfSplillsReloads() uses
+enum RegAllocSpillKind : uint8_t {
+  RSK_Spill,
+  RSK_Reload,
+  RSK_FoldedSpill,
+  RSK_FoldedReload,
+  RSK_Remat,
+  RSK_NumKinds
+};
+
+const char* getRegAllocSpillKindName(RegAllocSpillKind kind);
+
+// RegAllocSpillCost - spill code instructions and their block frequency weighted count
+struct RegAllocSpillCost {
+  uint32_t counts[RSK_NumKinds] = {};
+  // sum of the instructions' block frequencies relative to the entry block
+  double weights[RSK_NumKinds] = {};
+
+  bool empty() const;
+  double getTotalWeight() const;
+  void add(RegAllocSpillKind kind, double weight) {
+    counts[kind]++;
+    weights[kind] += weight;
+  }
+};
+
+// RegAllocSpillCycles - spill code of a function priced with the subtarget's scheduling
+// model, weighted by block frequency relative to the entry block
+// A folded instruction is priced as a whole, so its cycles bound the extra cost of the
+// folded memory operand from above. Without a scheduling model the latency falls back to
+// the model's defaults and the reciprocal throughput is 0.
+struct RegAllocSpillCycles {
+  double latency[RSK_NumKinds] = {};
+  double reciprocalThroughput[RSK_NumKinds] = {};
+
+  double getTotalLatency() const;
+  double getTotalReciprocalThroughput() const;
+};
+
+// RegAllocSpillCostStats - block frequency weighted spill code of a function
+//
+// Measured once allocation is done, before VirtRegRewriter, so the spill code still
+// refers to vRegs and spill slots:
+//  - a (folded) load or store of a spill slot is charged to the original vReg the
+//    spiller assigned that slot to
+//  - any other instruction defining a vReg split off an original one is a
+//    rematerialization, unless it already defined an original vReg when allocation
+//    started - splitting rewrites those defs to the new vRegs
+class RegAllocSpillCostStats {
+
+  private:
+    const MachineFunction* MF = nullptr;
+    const VirtRegMap* VRM = nullptr;
+    const MachineRegisterInfo* MRI = nullptr;
+    const MachineBlockFrequencyInfo* MBFI = nullptr;
+
+    std::vector<Register> originalVRegs;
+
+    // instructions that defined an original vReg when allocation started
+    DenseSet<const MachineInstr*> origDefs;
+
+    // spill slot -> original vReg
+    DenseMap<int, Register> slotOwners;
+
+    // indexed by original vReg index
+    std::vector<RegAllocSpillCost> vRegCosts;
+    RegAllocSpillCost totals;
+
+    // only with -regalloc-profile-sched-cost
+    bool priceCycles = false;
+    TargetSchedModel schedModel;
+    RegAllocSpillCycles cycles;
+
+    // Returns the original vReg a spill slot access is charged to, 0 if it is no spill slot
+    Register getSlotOwner(int FI) const;
+    Register getSlotOwner(ArrayRef<const MachineMemOperand*> accesses) const;
+
+  public:
+    // Resets the stats for a new function, priceCycles also prices the spill code with the
+    // scheduling model
+    void clear(const MachineFunction* MF, const VirtRegMap* VRM, const MachineRegisterInfo* MRI,
+               const MachineBlockFrequencyInfo* MBFI, bool priceCycles);
+
+    bool isTracking() const { return MBFI != nullptr; }
+
+    // Records a vReg of the original set along with its defs
+    void addOriginalVReg(Register reg);
+
+    // LiveRangeEdit is about to erase MI - keeps a recycled MachineInstr from being
+    // mistaken for an original def
+    void forgetInstruction(const MachineInstr* MI) { origDefs.erase(MI); }
+
+    // Walks the function and charges its spill code to the original vRegs
+    void compute();
+
+    // Classifies MI, returns false if it is no spill code. reg is the original vReg it is
+    // charged to, 0 if it could not be attributed
+    bool classify(const MachineInstr& MI, RegAllocSpillKind& kind, Register& reg) const;
+
+    const std::vector<Register>& getOriginalVRegs() const { return originalVRegs; }
+
+    const RegAllocSpillCost& get(Register reg) const {
+      return vRegCosts[Register::virtReg2Index(reg)];
+    }
+
+    // unattributed spill code included
+    const RegAllocSpillCost& getTotals() const { return totals; }
+
+    bool hasCycles() const { return priceCycles; }
+    const RegAllocSpillCycles& getCycles() const { return cycles; }
+};
+
+#endif // LLVM_CODEGEN_REGALLOCSPILLCOST_H
@@ -0,0 +1,106 @@
+#ifndef LLVM_CODEGEN_REGALLOCSPLITTREE_H
+#define LLVM_CODEGEN_REGALLOCSPLITTREE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/CodeGen/LiveIntervals.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/Register.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include <cstdint>
+#include <vector>
+
+using namespace llvm;
+
+// How a vReg of the split tree came to be
+enum RegAllocSplitKind : uint8_t {
+  // enqueued by seedLiveRegs(), the root of a tree
+  RSP_Original,
+  // SplitEditor products of RAGreedy::doRegionSplit, tryBlockSplit, tryLocalSplit and
+  // tryInstructionSplit
+  RSP_Region,
+  RSP_Block,
+  RSP_Local,
+  RSP_Instruction,
+  // new vRegs of the spiller, i.e. reload/spill temporaries and remats
+  RSP_Spill,
+  // connected components of a vReg separated by dead code elimination
+  RSP_Clone,
+  RSP_NumKinds
+};
+
+const char* getRegAllocSplitKindName(RegAllocSplitKind kind);
+
+// Where a vReg of the split tree ended up once allocation is done
+enum RegAllocSplitLocation : uint8_t {
+  // assigned a physReg
+  RSL_Register,
+  // spilled to its original's stack slot
+  RSL_Stack,
+  // split further, its children carry its live range
+  RSL_Split,
+  // no uses left, e.g. every use was rematerialized
+  RSL_Dead,
+  // none of the above - unassigned after a failed allocation
+  RSL_Unassigned
+};
+
+// RegAllocSplitNode - a vReg of a split tree
+struct RegAllocSplitNode {
+  // virtReg indices, parent and original are the node's own for RSP_Original
+  uint32_t vReg;
+  uint32_t parent;
+  uint32_t original;
+  // live interval size when the vReg was created (seeded for RSP_Original)
+  uint32_t size;
+  uint8_t kind;
+  uint8_t location;
+  bool hasChildren;
+  bool spilled;
+};
+
+// RegAllocSplitTree - split provenance of the original vRegs of a function
+//
+// VirtRegMap::getOriginal() only links a vReg to its original, so the direct parent and the
+// kind of split are recorded by RAGreedy as it splits and spills. Locations are resolved by
+// compute() once allocation is done.
+class RegAllocSplitTree {
+
+  private:
+    const VirtRegMap* VRM = nullptr;
+    const MachineRegisterInfo* MRI = nullptr;
+    LiveIntervals* LIS = nullptr;
+
+    // in creation order, originals first
+    std::vector<RegAllocSplitNode> nodes;
+    // virtReg index -> index into nodes, ~0u if not in any tree
+    std::vector<uint32_t> nodeOf;
+
+    // indexed like nodes, only meaningful for originals - see getRegFraction()
+    std::vector<float> regFractions;
+
+    RegAllocSplitNode* find(Register reg);
+    void addNode(Register reg, Register parent, RegAllocSplitKind kind);
+
+  public:
+    // Resets the tree for a new function
+    void clear(const VirtRegMap* VRM, const MachineRegisterInfo* MRI, LiveIntervals* LIS);
+
+    void addOriginal(const LiveInterval& LI);
+
+    // parent was split (or its spill created new vRegs) into children
+    void recordSplit(RegAllocSplitKind kind, Register parent, ArrayRef<unsigned> children);
+    void recordSpill(Register reg, ArrayRef<unsigned> products);
+    void recordClone(Register clone, Register reg) { addNode(clone, reg, RSP_Clone); }
+
+    // Resolves the locations and per original register fractions
+    void compute();
+
+    const std::vector<RegAllocSplitNode>& getNodes() const { return nodes; }
+
+    // Fraction of the original's live range that stayed in registers: the size of its
+    // register leaves over the size of its register and stack leaves. Spiller products
+    // are spill code rather than parts of the range and do not count.
+    float getRegFraction(Register original) const;
+};
+
+#endif // LLVM_CODEGEN_REGALLOCSPLITTREE_H
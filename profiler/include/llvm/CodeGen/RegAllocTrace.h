@@ -0,0 +1,177 @@
+#ifndef LLVM_CODEGEN_REGALLOCTRACE_H
+#define LLVM_CODEGEN_REGALLOCTRACE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/CodeGen/TargetRegisterInfo.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+
+// Binary columnar trace of register allocation statistics
+//
+// The file is a sequence of self-contained chunks. Every chunk holds the records of a run
+// of functions, so several llc processes can append to the same trace. All integers are
+// fixed-width little-endian and every table/column starts on an 8 byte boundary.
+//
+//   header         magic "RAPROFTR", u16 version, u16 header size, u32 numStrings,
+//                  u32 stringBytes, u32 numTables, u64 chunk size in bytes (header included)
+//   string table   u32 offsets[numStrings + 1], then the string bytes (not NUL terminated)
+//   tables         numTables times:
+//                    u32 name (string index), u32 numColumns, u64 numRows
+//                    numColumns column descriptors: u32 name (string index), u8 ColumnType, 3 pad bytes
+//                    numColumns columns of numRows values each
+//
+// Every chunk carries a "regclasses" and a "physregs" table (name per class ID / physReg
+// number) so IDs in the other tables can be resolved. Per-function tables start with a
+// "function" column holding the row of the function in that chunk's "functions" table.
+namespace RegAllocTrace {
+
+  const char Magic[8] = {'R', 'A', 'P', 'R', 'O', 'F', 'T', 'R'};
+  const uint16_t Version = 2;
+  const uint16_t HeaderSize = 32;
+
+  enum ColumnType : uint8_t {
+    CT_U8,
+    CT_U16,
+    CT_U32,
+    CT_U64,
+    CT_F32,
+    // u32 index into the chunk's string table
+    CT_Str
+  };
+
+  // Column declaration - the name has to outlive the writer (string literals)
+  struct ColumnDesc {
+    const char* name;
+    ColumnType type;
+  };
+
+  enum VRegFlags : uint8_t {
+    // the vReg ended up in the physReg stored in location
+    VF_Allocated = 1,
+    // the vReg was marked for splitting (RS_Split) during allocation
+    VF_SplitMarked = 2,
+    // the vReg was assigned the stack slot stored in location
+    VF_StackSlot = 4
+  };
+
+} // end namespace RegAllocTrace
+
+class RegAllocTraceWriter;
+
+// RegAllocTraceTable - column storage of one table
+// Rows are appended one value per column, in declaration order, followed by endRow()
+class RegAllocTraceTable {
+  friend class RegAllocTraceWriter;
+
+  private:
+    struct Column {
+      StringRef name;
+      RegAllocTrace::ColumnType type;
+      SmallVector<char, 0> data;
+    };
+
+    RegAllocTraceWriter& writer;
+    std::string name;
+    SmallVector<Column, 8> columns;
+    uint64_t numRows;
+
+    // column the next value goes to
+    unsigned nextColumn;
+
+    template <typename T>
+    RegAllocTraceTable& add(RegAllocTrace::ColumnType type, T value);
+
+  public:
+    RegAllocTraceTable(RegAllocTraceWriter& writer, StringRef name,
+                       ArrayRef<RegAllocTrace::ColumnDesc> columns);
+
+    uint64_t size() const { return numRows; }
+
+    RegAllocTraceTable& addU8(uint8_t value) { return add(RegAllocTrace::CT_U8, value); }
+    RegAllocTraceTable& addU16(uint16_t value) { return add(RegAllocTrace::CT_U16, value); }
+    RegAllocTraceTable& addU32(uint32_t value) { return add(RegAllocTrace::CT_U32, value); }
+    RegAllocTraceTable& addU64(uint64_t value) { return add(RegAllocTrace::CT_U64, value); }
+    RegAllocTraceTable& addF32(float value);
+    RegAllocTraceTable& addStr(StringRef value);
+
+    void endRow() {
+      assert(nextColumn == columns.size() && "incomplete trace row!");
+      nextColumn = 0;
+      numRows++;
+    }
+};
+
+// RegAllocTraceWriter - accumulates the trace tables for a module and writes them out
+// as one chunk on close, or earlier once the tables pass the flush threshold
+class RegAllocTraceWriter {
+
+  private:
+    std::unique_ptr<raw_fd_ostream> out;
+
+    // approximate table bytes that trigger writing a chunk
+    size_t flushThreshold;
+
+    // register info of the target - used to emit the class/physreg name tables
+    const TargetRegisterInfo* TRI;
+
+    // string table, ids are assigned in insertion order
+    StringMap<uint32_t> stringIds;
+    std::vector<StringRef> strings;
+    size_t stringBytes;
+
+    // tables in creation order - they outlive chunks, only their rows are cleared
+    std::vector<std::unique_ptr<RegAllocTraceTable>> tables;
+    StringMap<RegAllocTraceTable*> tablesByName;
+
+    // bytes the pending chunk will roughly take up
+    size_t pendingBytes() const;
+
+    // serializes the pending chunk and clears the tables
+    void writeChunk();
+
+  public:
+    RegAllocTraceWriter() : flushThreshold(0), TRI(nullptr), stringBytes(0) {}
+    ~RegAllocTraceWriter() { close(); }
+
+    // Opens fname in append mode - returns false (and warns) if it can't be opened
+    bool open(StringRef fname, size_t flushThreshold);
+
+    // Writes the pending chunk and closes the file
+    void close();
+
+    bool isOpen() const { return out != nullptr; }
+
+    // Sets the target whose class/physreg names go into the chunk
+    void setTarget(const TargetRegisterInfo* TRI) {
+      assert((!this->TRI || this->TRI == TRI) && "trace mixes targets!");
+      this->TRI = TRI;
+    }
+
+    uint32_t internString(StringRef str);
+
+    // Gets the table called name, creating it with the given columns on first use
+    RegAllocTraceTable& table(StringRef name, ArrayRef<RegAllocTrace::ColumnDesc> columns);
+
+    // Marks the end of a function's rows, writes a chunk if the flush threshold was passed
+    void endFunction();
+};
+
+template <typename T>
+RegAllocTraceTable& RegAllocTraceTable::add(RegAllocTrace::ColumnType type, T value) {
+  assert(nextColumn < columns.size() && columns[nextColumn].type == type &&
+         "trace value does not match the column type!");
+  SmallVectorImpl<char>& data = columns[nextColumn++].data;
+  for (unsigned i = 0; i < sizeof(T); ++i)
+    data.push_back((char)((uint64_t)value >> (8 * i)));
+  return *this;
+}
+
+#endif // LLVM_CODEGEN_REGALLOCTRACE_H
@@ -27,6 +27,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
@@ -43,6 +44,15 @@ static cl::opt<bool, true>
     VerifyRegAlloc("verify-regalloc", cl::location(RegAllocBase::VerifyEnabled),
                    cl::Hidden, cl::desc("Verify during register allocation"));
 
+// HKHAJ - per-vreg time trace spans. The time trace profiler drops spans
+// shorter than its granularity (-time-trace-granularity, in microseconds), so
+// that is the threshold for which selectOrSplit calls show up.
+static cl::opt<bool> TimeTraceSelectOrSplit(
+    "regalloc-time-trace-vregs", cl::Hidden,
+    cl::desc("Add a time trace span for every selectOrSplit call that takes "
+             "longer than the time trace granularity"),
+    cl::init(false));
+
 const char RegAllocBase::TimerGroupName[] = "regalloc";
 const char RegAllocBase::TimerGroupDescription[] = "Register Allocation";
 bool RegAllocBase::VerifyEnabled = false;
@@ -72,11 +82,15 @@ void RegAllocBase::init(VirtRegMap &vrm,
 void RegAllocBase::seedLiveRegs() {
   NamedRegionTimer T("seed", "Seed Live Regs", TimerGroupName,
                      TimerGroupDescription, TimePassesIsEnabled);
+  TimeTraceScope TimeScope("RegAllocSeedLiveRegs",
+                           VRM->getMachineFunction().getName());
   for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
     unsigned Reg = Register::index2VirtReg(i);
     if (MRI->reg_nodbg_empty(Reg))
       continue;
-    enqueue(&LIS->getInterval(Reg));
+    LiveInterval &LI = LIS->getInterval(Reg);
+    seededLiveReg(LI);
+    enqueue(&LI);
   }
 }
 
@@ -86,6 +100,10 @@ void RegAllocBase::seedLiveRegs() {
 void RegAllocBase::allocatePhysRegs() {
   seedLiveRegs();
 
+  TimeTraceScope TimeScope("RegAllocAssignLoop",
+                           VRM->getMachineFunction().getName());
+  const bool TraceVRegs = TimeTraceSelectOrSplit && timeTraceProfilerEnabled();
+
   // Continue assigning vregs one at a time to available physical registers.
   while (LiveInterval *VirtReg = dequeue()) {
     assert(!VRM->hasPhys(VirtReg->reg) && "Register already assigned");
@@ -93,6 +111,7 @@ void RegAllocBase::allocatePhysRegs() {
     // Unused registers can appear when the spiller coalesces snippets.
     if (MRI->reg_nodbg_empty(VirtReg->reg)) {
       LLVM_DEBUG(dbgs() << "Dropping unused " << *VirtReg << '\n');
+      droppedUnusedLiveReg(*VirtReg);
       aboutToRemoveInterval(*VirtReg);
       LIS->removeInterval(VirtReg->reg);
       continue;
@@ -111,7 +130,19 @@ void RegAllocBase::allocatePhysRegs() {
     using VirtRegVec = SmallVector<unsigned, 4>;
 
     VirtRegVec SplitVRegs;
-    unsigned AvailablePhysReg = selectOrSplit(*VirtReg, SplitVRegs);
+    unsigned AvailablePhysReg;
+    if (TraceVRegs) {
+      TimeTraceScope VRegScope("RegAllocSelectOrSplit", [&] {
+        std::string Detail;
+        raw_string_ostream OS(Detail);
+        OS << printReg(VirtReg->reg, TRI) << ':'
+           << TRI->getRegClassName(MRI->getRegClass(VirtReg->reg));
+        return OS.str();
+      });
+      AvailablePhysReg = selectOrSplit(*VirtReg, SplitVRegs);
+    } else {
+      AvailablePhysReg = selectOrSplit(*VirtReg, SplitVRegs);
+    }
 
     if (AvailablePhysReg == ~0u) {
       // selectOrSplit failed to find a register!
@@ -0,0 +1,25 @@
+#include "llvm/CodeGen/RegAllocCSRStats.h"
+
+using namespace llvm;
+
+void RegAllocCSRStats::recordDecision(Register reg, unsigned physReg, unsigned stage,
+                                      RegAllocCSRDecision::Alternative alternative,
+                                      uint64_t altCost, RegAllocCSRDecision::Outcome outcome) {
+  RegAllocCSRDecision decision;
+  decision.vReg = Register::virtReg2Index(reg);
+  decision.physReg = physReg;
+  decision.stage = stage;
+  decision.alternative = alternative;
+  decision.outcome = outcome;
+  decision.csrCost = csrCost;
+  decision.altCost = altCost;
+  decisions.push_back(decision);
+}
+
+void RegAllocCSRStats::countUsedCSRs(const MachineRegisterInfo& MRI, const LiveRegMatrix& Matrix) {
+  numCSRs = numUsedCSRs = 0;
+  for (const MCPhysReg* CSR = MRI.getCalleeSavedRegs(); CSR && *CSR; ++CSR) {
+    numCSRs++;
+    numUsedCSRs += Matrix.isPhysRegUsed(*CSR);
+  }
+}
@@ -0,0 +1,55 @@
+#include "llvm/CodeGen/RegAllocEvictionGraph.h"
+#include <algorithm>
+
+using namespace llvm;
+
+void RegAllocEvictionGraph::record(Register evictor, Register evictee, unsigned physReg,
+                                   unsigned cascade, unsigned brokenHints, float maxWeight) {
+  RegAllocEviction E;
+  E.evictor = Register::virtReg2Index(evictor);
+  E.evictee = Register::virtReg2Index(evictee);
+  E.cascade = cascade;
+  E.brokenHints = brokenHints;
+  E.maxWeight = maxWeight;
+  E.physReg = physReg;
+
+  // extend the longest chain that ended in an eviction of the evictor
+  unsigned edge = edges.size();
+  unsigned length = 1;
+  unsigned prev = ~0u;
+  auto it = chainEnds.find(E.evictor);
+  if (it != chainEnds.end()) {
+    length = it->second.length + 1;
+    prev = it->second.edge;
+  }
+
+  edges.push_back(E);
+  chainLength.push_back(length);
+  chainPrev.push_back(prev);
+
+  ChainEnd& end = chainEnds[E.evictee];
+  if (length > end.length) {
+    end.length = length;
+    end.edge = edge;
+  }
+
+  evictCounts[E.evictee]++;
+}
+
+unsigned RegAllocEvictionGraph::maxEvictionsPerVReg() const {
+  unsigned maxCount = 0;
+  for (const auto& count : evictCounts)
+    maxCount = std::max(maxCount, count.second);
+  return maxCount;
+}
+
+void RegAllocEvictionGraph::getLongestChain(SmallVectorImpl<const RegAllocEviction*>& chain) const {
+  chain.clear();
+  if (edges.empty())
+    return;
+
+  unsigned last = std::max_element(chainLength.begin(), chainLength.end()) - chainLength.begin();
+  for (unsigned edge = last; edge != ~0u; edge = chainPrev[edge])
+    chain.push_back(&edges[edge]);
+  std::reverse(chain.begin(), chain.end());
+}
@@ -0,0 +1,164 @@
+#include "llvm/CodeGen/RegAllocGapKernel.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cassert>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define REGALLOC_GAP_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace llvm;
+
+/********************* Scalar *******************************/
+
+static unsigned findNotBelowScalar(const int32_t* keys, unsigned begin, unsigned end,
+                                   int32_t value) {
+  while (begin != end && keys[begin] < value)
+    ++begin;
+  return begin;
+}
+
+static void raiseScalar(float* weights, unsigned begin, unsigned end, float weight) {
+  for (unsigned i = begin; i != end; ++i)
+    weights[i] = std::max(weights[i], weight);
+}
+
+static float maxScalar(const float* weights, unsigned begin, unsigned end) {
+  assert(begin != end && "max of an empty range!");
+  float result = weights[begin];
+  for (unsigned i = begin + 1; i != end; ++i)
+    result = std::max(result, weights[i]);
+  return result;
+}
+
+#ifdef REGALLOC_GAP_KERNEL_X86
+
+/********************* SSE2 *******************************/
+
+// The scans mostly stop within a few keys, so the first few are checked one at a time
+// before the vector loop gets going.
+static const unsigned ScalarLeadIn = 4;
+
+__attribute__((target("sse2")))
+static unsigned findNotBelowSSE2(const int32_t* keys, unsigned begin, unsigned end,
+                                 int32_t value) {
+  for (unsigned lead = std::min(end, begin + ScalarLeadIn); begin != lead; ++begin)
+    if (keys[begin] >= value)
+      return begin;
+
+  const __m128i v = _mm_set1_epi32(value);
+  for (; begin + 4 <= end; begin += 4) {
+    __m128i below = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(keys + begin)), v);
+    unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(below));
+    if (mask != 0xf)
+      return begin + countTrailingOnes(mask);
+  }
+  return findNotBelowScalar(keys, begin, end, value);
+}
+
+__attribute__((target("sse2")))
+static void raiseSSE2(float* weights, unsigned begin, unsigned end, float weight) {
+  const __m128 w = _mm_set1_ps(weight);
+  for (; begin + 4 <= end; begin += 4)
+    _mm_storeu_ps(weights + begin, _mm_max_ps(_mm_loadu_ps(weights + begin), w));
+  raiseScalar(weights, begin, end, weight);
+}
+
+__attribute__((target("sse2")))
+static float maxSSE2(const float* weights, unsigned begin, unsigned end) {
+  assert(begin != end && "max of an empty range!");
+  if (end - begin < 8)
+    return maxScalar(weights, begin, end);
+
+  __m128 acc = _mm_loadu_ps(weights + begin);
+  for (begin += 4; begin + 4 <= end; begin += 4)
+    acc = _mm_max_ps(acc, _mm_loadu_ps(weights + begin));
+  acc = _mm_max_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_max_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  float result = _mm_cvtss_f32(acc);
+  return begin != end ? std::max(result, maxScalar(weights, begin, end)) : result;
+}
+
+/********************* AVX2 *******************************/
+
+__attribute__((target("avx2")))
+static unsigned findNotBelowAVX2(const int32_t* keys, unsigned begin, unsigned end,
+                                 int32_t value) {
+  for (unsigned lead = std::min(end, begin + ScalarLeadIn); begin != lead; ++begin)
+    if (keys[begin] >= value)
+      return begin;
+
+  const __m256i v = _mm256_set1_epi32(value);
+  for (; begin + 8 <= end; begin += 8) {
+    __m256i below = _mm256_cmpgt_epi32(v, _mm256_loadu_si256((const __m256i*)(keys + begin)));
+    unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(below));
+    if (mask != 0xff)
+      return begin + countTrailingOnes(mask);
+  }
+  return findNotBelowScalar(keys, begin, end, value);
+}
+
+__attribute__((target("avx2")))
+static void raiseAVX2(float* weights, unsigned begin, unsigned end, float weight) {
+  const __m256 w = _mm256_set1_ps(weight);
+  for (; begin + 8 <= end; begin += 8)
+    _mm256_storeu_ps(weights + begin, _mm256_max_ps(_mm256_loadu_ps(weights + begin), w));
+  raiseScalar(weights, begin, end, weight);
+}
+
+__attribute__((target("avx2")))
+static float maxAVX2(const float* weights, unsigned begin, unsigned end) {
+  assert(begin != end && "max of an empty range!");
+  if (end - begin < 16)
+    return maxScalar(weights, begin, end);
+
+  __m256 acc = _mm256_loadu_ps(weights + begin);
+  for (begin += 8; begin + 8 <= end; begin += 8)
+    acc = _mm256_max_ps(acc, _mm256_loadu_ps(weights + begin));
+  __m128 half = _mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  half = _mm_max_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 0, 3, 2)));
+  half = _mm_max_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(2, 3, 0, 1)));
+  float result = _mm_cvtss_f32(half);
+  return begin != end ? std::max(result, maxScalar(weights, begin, end)) : result;
+}
+
+#endif // REGALLOC_GAP_KERNEL_X86
+
+/********************* RegAllocGapKernel *******************************/
+
+RegAllocGapKernelKind RegAllocGapKernel::hostKind() {
+#ifdef REGALLOC_GAP_KERNEL_X86
+  if (__builtin_cpu_supports("avx2"))
+    return RGK_AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return RGK_SSE2;
+#endif
+  return RGK_Scalar;
+}
+
+RegAllocGapKernel::RegAllocGapKernel(RegAllocGapKernelKind requested) {
+  const RegAllocGapKernelKind host = hostKind();
+  kind = requested == RGK_Auto ? host : std::min(requested, host);
+
+  switch (kind) {
+#ifdef REGALLOC_GAP_KERNEL_X86
+  case RGK_AVX2:
+    findNotBelowFn = findNotBelowAVX2;
+    raiseFn = raiseAVX2;
+    maxFn = maxAVX2;
+    return;
+  case RGK_SSE2:
+    findNotBelowFn = findNotBelowSSE2;
+    raiseFn = raiseSSE2;
+    maxFn = maxSSE2;
+    return;
+#endif
+  default:
+    kind = RGK_Scalar;
+    findNotBelowFn = findNotBelowScalar;
+    raiseFn = raiseScalar;
+    maxFn = maxScalar;
+    return;
+  }
+}
@@ -47,6 +47,7 @@
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/MachineOperand.h"
 #include "llvm/CodeGen/MachineOptimizationRemarkEmitter.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
@@ -66,12 +67,18 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/CodeGen/RegAllocGapKernel.h"
+#include "llvm/CodeGen/RegAllocPriorityQueue.h"
 #include "llvm/CodeGen/RegAllocProfiler.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <queue>
@@ -111,6 +118,14 @@ static cl::opt<bool> ExhaustiveSearch(
              "and interference cutoffs of last chance recoloring"),
     cl::Hidden);
 
+// HKHAJ - adaptive last chance recoloring cutoffs
+static cl::opt<unsigned> LastChanceRecoloringTimeBudget(
+    "lcr-time-budget-us", cl::Hidden,
+    cl::desc("Halve the last chance recoloring depth and interference "
+             "limits of a function each time its recoloring time exceeds "
+             "another multiple of this many microseconds (0 disables)"),
+    cl::init(0));
+
 static cl::opt<bool> EnableLocalReassignment(
     "enable-local-reassign", cl::Hidden,
     cl::desc("Local reassignment can yield better allocation decisions, but "
@@ -143,6 +158,81 @@ static cl::opt<bool> ConsiderLocalIntervalCost(
              "candidate when choosing the best split candidate."),
     cl::init(false));
 
+// HKHAJ - concurrent evaluation of global split candidates
+static cl::opt<unsigned> SplitThreads(
+    "regalloc-split-threads", cl::Hidden,
+    cl::desc("Threads solving the spill placement of global split candidates "
+             "concurrently, the chosen split is the same (0 or 1: one at a "
+             "time)"),
+    cl::init(0));
+
+static cl::opt<unsigned> SplitThreadsMinBlocks(
+    "regalloc-split-threads-min-blocks", cl::Hidden,
+    cl::desc("Live ranges through fewer blocks solve their split candidates "
+             "one at a time"),
+    cl::init(256));
+
+static cl::opt<bool> VerifySplitThreads(
+    "regalloc-split-threads-verify", cl::Hidden,
+    cl::desc("Also evaluate every concurrently solved split candidate one at "
+             "a time and abort if the solutions differ"),
+    cl::init(false));
+
+// HKHAJ - work queue implementation, both dequeue in the same order
+static cl::opt<RegAllocPriorityQueueKind> RegAllocPQueue(
+    "regalloc-pqueue", cl::Hidden,
+    cl::desc("Priority queue implementation of the greedy allocator"),
+    cl::values(clEnumValN(RPQ_BinaryHeap, "binary", "Binary heap of pairs"),
+               clEnumValN(RPQ_Bucketed, "bucketed",
+                          "Heaps bucketed by the priority's top byte")),
+    cl::init(RPQ_BinaryHeap));
+
+// HKHAJ - vector kernels of the local split gap scans, all levels split alike
+static cl::opt<RegAllocGapKernelKind> RegAllocGapKernelLevel(
+    "regalloc-gap-kernel", cl::Hidden,
+    cl::desc("Instruction set of the local split gap weight kernels"),
+    cl::values(clEnumValN(RGK_Auto, "auto", "Best level the host supports"),
+               clEnumValN(RGK_Scalar, "scalar", "Portable scalar loops"),
+               clEnumValN(RGK_SSE2, "sse2", "4 lanes"),
+               clEnumValN(RGK_AVX2, "avx2", "8 lanes")),
+    cl::init(RGK_Auto));
+
+// HKHAJ - profiler options
+static cl::opt<bool> EnableRegAllocProfile(
+    "regalloc-profile", cl::Hidden,
+    cl::desc("Collect register allocation statistics with RegAllocProfiler"),
+    cl::init(false));
+
+static cl::opt<std::string> RegAllocProfileFile(
+    "regalloc-profile-file", cl::Hidden,
+    cl::desc("File the register allocation profiler appends its "
+             "per-function statistics to"),
+    cl::init("regalloc_dump_bw.txt"));
+
+static cl::opt<unsigned> RegAllocProfileBufferSize(
+    "regalloc-profile-buffer-size", cl::Hidden,
+    cl::desc("Number of bytes of profiler records buffered in memory before "
+             "they are written to the profile file"),
+    cl::init(1 << 20));
+
+static cl::opt<std::string> RegAllocProfileTraceFile(
+    "regalloc-profile-trace", cl::Hidden,
+    cl::desc("File the register allocation profiler appends its binary "
+             "columnar trace to (disabled when empty)"),
+    cl::init(""));
+
+static cl::opt<bool> RegAllocProfilePerfCounters(
+    "regalloc-profile-perf-counters", cl::Hidden,
+    cl::desc("Count instructions, cycles, LLC misses and branch misses of the "
+             "allocator phases with perf_event_open (Linux only)"),
+    cl::init(false));
+
+static cl::opt<bool> RegAllocProfileSchedCost(
+    "regalloc-profile-sched-cost", cl::Hidden,
+    cl::desc("Price the spill code of each function with the subtarget's "
+             "scheduling model, weighted by block frequency"),
+    cl::init(false));
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -152,12 +242,12 @@ class RAGreedy : public MachineFunctionPass,
                  public RegAllocBase,
                  private LiveRangeEdit::Delegate {
   // Convenient shortcuts.
-  using PQueue = std::priority_queue<std::pair<unsigned, unsigned>>;
+  using PQueue = RegAllocPriorityQueue;
   using SmallLISet = SmallPtrSet<LiveInterval *, 4>;
   using SmallVirtRegSet = SmallSet<unsigned, 16>;
 
-  // HKHAJ - added container for all split-marked vRegs. Used by the RAProfiler
-  std::set<Register> vRegsMarkedToSplit;
+  // HKHAJ - profiler entry points, compiled out with LLVM_REGALLOC_PROFILER=0
+  DefaultRegAllocProfilerHooks ProfilerHooks;
 
   // context
   MachineFunction *MF;
@@ -240,6 +330,16 @@ class RAGreedy : public MachineFunctionPass,
 
   uint8_t CutOffInfo;
 
+  /// HKHAJ - Last chance recoloring limits of the current function. They start
+  /// out at -lcr-max-depth / -lcr-max-interf and are lowered once the
+  /// recoloring time exceeds -lcr-time-budget-us.
+  unsigned LCRMaxDepth;
+  unsigned LCRMaxInterference;
+  /// Time spent in outermost last chance recoloring calls of the function, and
+  /// the number of times the limits have been lowered.
+  std::chrono::nanoseconds LCRTime;
+  unsigned LCRBudgetSteps;
+
 #ifndef NDEBUG
   static const char *const StageName[];
 #endif
@@ -262,16 +362,25 @@ class RAGreedy : public MachineFunctionPass,
 
   void setStage(const LiveInterval &VirtReg, LiveRangeStage Stage) {
     ExtraRegInfo.resize(MRI->getNumVirtRegs());
+    ProfilerHooks.recordStageTransition(ExtraRegInfo[VirtReg.reg].Stage, Stage);
     ExtraRegInfo[VirtReg.reg].Stage = Stage;
   }
 
+  /// Record an allocation decision for VirtReg in the profiler's event ring.
+  void recordEvent(RegAllocEventKind Kind, const LiveInterval &VirtReg,
+                   unsigned PhysReg) {
+    ProfilerHooks.recordEvent(Kind, VirtReg, PhysReg, getStage(VirtReg));
+  }
+
   template<typename Iterator>
   void setStage(Iterator Begin, Iterator End, LiveRangeStage NewStage) {
     ExtraRegInfo.resize(MRI->getNumVirtRegs());
     for (;Begin != End; ++Begin) {
       unsigned Reg = *Begin;
-      if (ExtraRegInfo[Reg].Stage == RS_New)
+      if (ExtraRegInfo[Reg].Stage == RS_New) {
+        ProfilerHooks.recordStageTransition(RS_New, NewStage);
         ExtraRegInfo[Reg].Stage = NewStage;
+      }
     }
   }
 
@@ -395,6 +504,72 @@ class RAGreedy : public MachineFunctionPass,
   /// class.
   SmallVector<GlobalSplitCandidate, 32> GlobalCand;
 
+  /// HKHAJ - Spill placement solution of a global split candidate, as the
+  /// sequential loop in calculateRegionSplitCost would have computed it.
+  struct SplitSolution {
+    // addSplitConstraints found bundles with positive bias
+    bool Constrained;
+    // growRegion succeeded, LiveBundles and ActiveBlocks are valid
+    bool Grown;
+    unsigned GrowIterations;
+    BlockFrequency StaticCost;
+    BitVector LiveBundles;
+    SmallVector<unsigned, 8> ActiveBlocks;
+    SmallVector<SpillPlacement::BlockConstraint, 8> Constraints;
+  };
+
+  /// HKHAJ - Solves split candidates on a SplitPool thread. It has its own
+  /// SpillPlacement and InterferenceCache, so the pass' ones stay untouched.
+  struct SplitWorker {
+    std::unique_ptr<SpillPlacement> SpillPlacer;
+    InterferenceCache IntfCache;
+    GlobalSplitCandidate Cand;
+  };
+
+  std::unique_ptr<ThreadPool> SplitPool;
+  SmallVector<std::unique_ptr<SplitWorker>, 8> SplitWorkers;
+  /// Workers set up for the current function.
+  unsigned NumReadySplitWorkers = 0;
+  /// Indexed like the candidates passed to solveSplitCandidates.
+  std::vector<SplitSolution> SplitSolutions;
+
+  /// HKHAJ - Kernels of the local split gap scans, see -regalloc-gap-kernel.
+  RegAllocGapKernel GapKernel;
+  /// Use slots bounding each gap of the range tryLocalSplit works on, as
+  /// distances from its first use: the boundary index of UseSlots[i+1] and
+  /// its base index. calcGapWeights scans these instead of the SlotIndexes.
+  SmallVector<int32_t, 8> GapBoundaryKeys;
+  SmallVector<int32_t, 8> GapBaseKeys;
+
+  /// HKHAJ - LiveIntervalUnion segments interference queries have visited so
+  /// far, 0 unless the profiler counts the interference of this function.
+  unsigned segmentsVisited() const {
+    return ProfilerHooks.isTrackingInterference()
+               ? LiveIntervalUnion::getSegmentsVisited()
+               : 0;
+  }
+
+  /// HKHAJ - LiveRegMatrix::checkInterference, counted by the profiler with
+  /// the segments its unit queries visited.
+  LiveRegMatrix::InterferenceKind checkInterference(LiveInterval &VirtReg,
+                                                    unsigned PhysReg) {
+    if (!ProfilerHooks.isTrackingInterference())
+      return Matrix->checkInterference(VirtReg, PhysReg);
+    unsigned Visited = segmentsVisited();
+    LiveRegMatrix::InterferenceKind IK =
+        Matrix->checkInterference(VirtReg, PhysReg);
+    ProfilerHooks.recordCheckInterference(PhysReg, segmentsVisited() - Visited);
+    return IK;
+  }
+  bool checkInterference(SlotIndex Start, SlotIndex End, unsigned PhysReg) {
+    if (!ProfilerHooks.isTrackingInterference())
+      return Matrix->checkInterference(Start, End, PhysReg);
+    unsigned Visited = segmentsVisited();
+    bool Interference = Matrix->checkInterference(Start, End, PhysReg);
+    ProfilerHooks.recordCheckInterference(PhysReg, segmentsVisited() - Visited);
+    return Interference;
+  }
+
   enum : unsigned { NoCand = ~0u };
 
   /// Candidate map. Each edge bundle is assigned to a GlobalCand entry, or to
@@ -424,11 +599,19 @@ public:
   /// RAGreedy analysis usage.
   void getAnalysisUsage(AnalysisUsage &AU) const override;
   void releaseMemory() override;
+  bool doInitialization(Module &M) override;
+  bool doFinalization(Module &M) override;
   Spiller &spiller() override { return *SpillerInstance; }
   void enqueue(LiveInterval *LI) override;
   LiveInterval *dequeue() override;
   unsigned selectOrSplit(LiveInterval&, SmallVectorImpl<unsigned>&) override;
   void aboutToRemoveInterval(LiveInterval &) override;
+#if LLVM_REGALLOC_PROFILER
+  void seededLiveReg(LiveInterval &LI) override { ProfilerHooks.seedVReg(LI); }
+  void droppedUnusedLiveReg(LiveInterval &) override {
+    ProfilerHooks.recordDroppedUnused();
+  }
+#endif
 
   /// Perform register allocation.
   bool runOnMachineFunction(MachineFunction &mf) override;
@@ -447,13 +630,33 @@ private:
   bool LRE_CanEraseVirtReg(unsigned) override;
   void LRE_WillShrinkVirtReg(unsigned) override;
   void LRE_DidCloneVirtReg(unsigned, unsigned) override;
+  /// HKHAJ - erased instructions must not be mistaken for original defs by
+  /// the spill cost accounting.
+  void LRE_WillEraseInstruction(MachineInstr *MI) override {
+    ProfilerHooks.forgetInstruction(MI);
+  }
   void enqueue(PQueue &CurQueue, LiveInterval *LI);
   LiveInterval *dequeue(PQueue &CurQueue);
 
   BlockFrequency calcSpillCost();
   bool addSplitConstraints(InterferenceCache::Cursor, BlockFrequency&);
-  bool addThroughConstraints(InterferenceCache::Cursor, ArrayRef<unsigned>);
+  bool addSplitConstraints(SpillPlacement &,
+                           SmallVectorImpl<SpillPlacement::BlockConstraint> &,
+                           InterferenceCache::Cursor, BlockFrequency &);
+  bool addThroughConstraints(SpillPlacement &, InterferenceCache::Cursor,
+                             ArrayRef<unsigned>);
   bool growRegion(GlobalSplitCandidate &Cand);
+  bool growRegion(SpillPlacement &, GlobalSplitCandidate &Cand,
+                  unsigned &Iterations);
+  bool shouldSolveSplitsInParallel() const;
+  void setUpSplitWorkers(unsigned NumWorkers);
+  void solveSplitCandidate(SplitWorker &, unsigned PhysReg,
+                           BlockFrequency BestCost, SplitSolution &);
+  void solveSplitCandidates(ArrayRef<unsigned> PhysRegs,
+                            BlockFrequency BestCost);
+  bool adoptSplitSolution(GlobalSplitCandidate &Cand, SplitSolution &);
+  void verifySplitSolution(GlobalSplitCandidate &Cand, const SplitSolution &,
+                           BlockFrequency BestCost);
   bool splitCanCauseEvictionChain(unsigned Evictee, GlobalSplitCandidate &Cand,
                                   unsigned BBNumber,
                                   const AllocationOrder &Order);
@@ -477,7 +680,7 @@ private:
                                     LiveInterval &VirtReg, SlotIndex Start,
                                     SlotIndex End, float *BestEvictWeight);
   void evictInterference(LiveInterval&, unsigned,
-                         SmallVectorImpl<unsigned>&);
+                         SmallVectorImpl<unsigned>&, const EvictionCost&);
   bool mayRecolorAllInterferences(unsigned PhysReg, LiveInterval &VirtReg,
                                   SmallLISet &RecoloringCandidates,
                                   const SmallVirtRegSet &FixedRegisters);
@@ -519,6 +722,9 @@ private:
   unsigned tryLastChanceRecoloring(LiveInterval &, AllocationOrder &,
                                    SmallVectorImpl<unsigned> &,
                                    SmallVirtRegSet &, unsigned);
+  unsigned runLastChanceRecoloring(LiveInterval &, AllocationOrder &,
+                                   SmallVectorImpl<unsigned> &,
+                                   SmallVirtRegSet &, unsigned);
   bool tryRecoloringCandidates(PQueue &, SmallVectorImpl<unsigned> &,
                                SmallVirtRegSet &, unsigned);
   void tryHintRecoloring(LiveInterval &);
@@ -602,7 +808,9 @@ FunctionPass* llvm::createGreedyRegisterAllocator() {
   return new RAGreedy();
 }
 
-RAGreedy::RAGreedy(): MachineFunctionPass(ID) {
+RAGreedy::RAGreedy()
+    : MachineFunctionPass(ID), Queue(RegAllocPQueue),
+      GapKernel(RegAllocGapKernelLevel) {
 }
 
 void RAGreedy::getAnalysisUsage(AnalysisUsage &AU) const {
@@ -671,18 +879,41 @@ void RAGreedy::LRE_DidCloneVirtReg(unsigned New, unsigned Old) {
   // be split into connected components. The new components are much smaller
   // than the original, so they should get a new chance at being assigned.
   // same stage as the parent.
+  ProfilerHooks.recordStageTransition(ExtraRegInfo[Old].Stage, RS_Assign);
   ExtraRegInfo[Old].Stage = RS_Assign;
   ExtraRegInfo.grow(New);
   ExtraRegInfo[New] = ExtraRegInfo[Old];
+  ProfilerHooks.recordClone(New, Old);
+}
+
+bool RAGreedy::doInitialization(Module &M) {
+  ProfilerHooks.beginModule(EnableRegAllocProfile, RegAllocProfileFile,
+                            RegAllocProfileTraceFile,
+                            RegAllocProfileBufferSize,
+                            RegAllocProfilePerfCounters);
+  return false;
+}
+
+bool RAGreedy::doFinalization(Module &M) {
+  ProfilerHooks.endModule();
+  return false;
 }
 
 void RAGreedy::releaseMemory() {
   SpillerInstance.reset();
   ExtraRegInfo.clear();
   GlobalCand.clear();
+  // HKHAJ - the split workers' SpillPlacements are not known to the pass
+  // manager, release them like it releases ours.
+  for (std::unique_ptr<SplitWorker> &Worker : SplitWorkers)
+    Worker->SpillPlacer->releaseMemory();
+  NumReadySplitWorkers = 0;
 }
 
-void RAGreedy::enqueue(LiveInterval *LI) { enqueue(Queue, LI); }
+void RAGreedy::enqueue(LiveInterval *LI) {
+  enqueue(Queue, LI);
+  ProfilerHooks.recordEnqueue(Queue.size());
+}
 
 void RAGreedy::enqueue(PQueue &CurQueue, LiveInterval *LI) {
   // Prioritize live ranges by size, assigning larger ranges first.
@@ -694,8 +925,10 @@ void RAGreedy::enqueue(PQueue &CurQueue, LiveInterval *LI) {
   unsigned Prio;
 
   ExtraRegInfo.grow(Reg);
-  if (ExtraRegInfo[Reg].Stage == RS_New)
+  if (ExtraRegInfo[Reg].Stage == RS_New) {
+    ProfilerHooks.recordStageTransition(RS_New, RS_Assign);
     ExtraRegInfo[Reg].Stage = RS_Assign;
+  }
 
   if (ExtraRegInfo[Reg].Stage == RS_Split) {
     // Unsplit ranges that couldn't be allocated immediately are deferred until
@@ -748,7 +981,14 @@ void RAGreedy::enqueue(PQueue &CurQueue, LiveInterval *LI) {
   CurQueue.push(std::make_pair(Prio, ~Reg));
 }
 
-LiveInterval *RAGreedy::dequeue() { return dequeue(Queue); }
+LiveInterval *RAGreedy::dequeue() {
+  const size_t Depth = Queue.size();
+  LiveInterval *LI = dequeue(Queue);
+  if (LI)
+    ProfilerHooks.recordDequeue(VRM->getOriginal(LI->reg), getStage(*LI),
+                                Depth);
+  return LI;
+}
 
 LiveInterval *RAGreedy::dequeue(PQueue &CurQueue) {
   if (CurQueue.empty())
@@ -770,7 +1010,7 @@ unsigned RAGreedy::tryAssign(LiveInterval &VirtReg,
   Order.rewind();
   unsigned PhysReg;
   while ((PhysReg = Order.next()))
-    if (!Matrix->checkInterference(VirtReg, PhysReg))
+    if (!checkInterference(VirtReg, PhysReg))
       break;
   if (!PhysReg || Order.isHint())
     return PhysReg;
@@ -785,7 +1025,7 @@ unsigned RAGreedy::tryAssign(LiveInterval &VirtReg,
       EvictionCost MaxCost;
       MaxCost.setBrokenHints(1);
       if (canEvictInterference(VirtReg, Hint, true, MaxCost, FixedRegisters)) {
-        evictInterference(VirtReg, Hint, NewVRegs);
+        evictInterference(VirtReg, Hint, NewVRegs, MaxCost);
         return Hint;
       }
       // Record the missed hint, we may be able to recover
@@ -877,7 +1117,7 @@ bool RAGreedy::canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
                                     bool IsHint, EvictionCost &MaxCost,
                                     const SmallVirtRegSet &FixedRegisters) {
   // It is only possible to evict virtual register interference.
-  if (Matrix->checkInterference(VirtReg, PhysReg) > LiveRegMatrix::IK_VirtReg)
+  if (checkInterference(VirtReg, PhysReg) > LiveRegMatrix::IK_VirtReg)
     return false;
 
   bool IsLocal = LIS->intervalIsInOneMBB(VirtReg);
@@ -896,8 +1136,11 @@ bool RAGreedy::canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
   EvictionCost Cost;
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
     LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    unsigned Visited = segmentsVisited();
+    unsigned NumIntf = Q.collectInterferingVRegs(10);
+    ProfilerHooks.recordQuery(PhysReg, segmentsVisited() - Visited);
     // If there is 10 or more interferences, chances are one is heavier.
-    if (Q.collectInterferingVRegs(10) >= 10)
+    if (NumIntf >= 10)
       return false;
 
     // Check if any interfering live range is heavier than MaxWeight.
@@ -978,6 +1221,8 @@ bool RAGreedy::canEvictInterferenceInRange(LiveInterval &VirtReg,
 
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
     LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    // Only reads the interference collected so far, it visits nothing.
+    ProfilerHooks.recordQuery(PhysReg, 0);
 
     // Check if any interfering live range is heavier than MaxWeight.
     for (unsigned i = Q.interferingVRegs().size(); i; --i) {
@@ -1049,8 +1294,11 @@ unsigned RAGreedy::getCheapestEvicteeWeight(const AllocationOrder &Order,
 /// evictInterference - Evict any interferring registers that prevent VirtReg
 /// from being assigned to Physreg. This assumes that canEvictInterference
 /// returned true.
+/// HKHAJ - Cost is the EvictionCost canEvictInterference() accepted, it is
+/// only used for profiling.
 void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
-                                 SmallVectorImpl<unsigned> &NewVRegs) {
+                                 SmallVectorImpl<unsigned> &NewVRegs,
+                                 const EvictionCost &Cost) {
   // Make sure that VirtReg has a cascade number, and assign that cascade
   // number to every evicted register. These live ranges than then only be
   // evicted by a newer cascade, preventing infinite loops.
@@ -1060,6 +1308,7 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
 
   LLVM_DEBUG(dbgs() << "evicting " << printReg(PhysReg, TRI)
                     << " interference: Cascade " << Cascade << '\n');
+  recordEvent(RAE_Evict, VirtReg, PhysReg);
 
   // Collect all interfering virtregs first.
   SmallVector<LiveInterval*, 8> Intfs;
@@ -1069,7 +1318,9 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
     // should be fast, we may need to recalculate if when different physregs
     // overlap the same register unit so we had different SubRanges queried
     // against it.
+    unsigned Visited = segmentsVisited();
     Q.collectInterferingVRegs();
+    ProfilerHooks.recordQuery(PhysReg, segmentsVisited() - Visited);
     ArrayRef<LiveInterval*> IVR = Q.interferingVRegs();
     Intfs.append(IVR.begin(), IVR.end());
   }
@@ -1082,6 +1333,9 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
       continue;
 
     LastEvicted.addEviction(PhysReg, VirtReg.reg, Intf->reg);
+    recordEvent(RAE_Evicted, *Intf, PhysReg);
+    ProfilerHooks.recordEviction(VirtReg, *Intf, PhysReg, Cascade,
+                                 Cost.BrokenHints, Cost.MaxWeight);
 
     Matrix->unassign(*Intf);
     assert((ExtraRegInfo[Intf->reg].Cascade < Cascade ||
@@ -1174,7 +1428,7 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
   if (!BestPhys)
     return 0;
 
-  evictInterference(VirtReg, BestPhys, NewVRegs);
+  evictInterference(VirtReg, BestPhys, NewVRegs, BestCost);
   return BestPhys;
 }
 
@@ -1189,6 +1443,15 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
 /// Return false if there are no bundles with positive bias.
 bool RAGreedy::addSplitConstraints(InterferenceCache::Cursor Intf,
                                    BlockFrequency &Cost) {
+  return addSplitConstraints(*SpillPlacer, SplitConstraints, Intf, Cost);
+}
+
+/// HKHAJ - addSplitConstraints on the given SpillPlacement and constraints
+/// vector, so split workers can use their own.
+bool RAGreedy::addSplitConstraints(
+    SpillPlacement &SpillPlacer,
+    SmallVectorImpl<SpillPlacement::BlockConstraint> &SplitConstraints,
+    InterferenceCache::Cursor Intf, BlockFrequency &Cost) {
   ArrayRef<SplitAnalysis::BlockInfo> UseBlocks = SA->getUseBlocks();
 
   // Reset interference dependent info.
@@ -1248,19 +1511,20 @@ bool RAGreedy::addSplitConstraints(InterferenceCache::Cursor Intf,
 
     // Accumulate the total frequency of inserted spill code.
     while (Ins--)
-      StaticCost += SpillPlacer->getBlockFrequency(BC.Number);
+      StaticCost += SpillPlacer.getBlockFrequency(BC.Number);
   }
   Cost = StaticCost;
 
   // Add constraints for use-blocks. Note that these are the only constraints
   // that may add a positive bias, it is downhill from here.
-  SpillPlacer->addConstraints(SplitConstraints);
-  return SpillPlacer->scanActiveBundles();
+  SpillPlacer.addConstraints(SplitConstraints);
+  return SpillPlacer.scanActiveBundles();
 }
 
 /// addThroughConstraints - Add constraints and links to SpillPlacer from the
 /// live-through blocks in Blocks.
-bool RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
+bool RAGreedy::addThroughConstraints(SpillPlacement &SpillPlacer,
+                                     InterferenceCache::Cursor Intf,
                                      ArrayRef<unsigned> Blocks) {
   const unsigned GroupSize = 8;
   SpillPlacement::BlockConstraint BCS[GroupSize];
@@ -1275,7 +1539,7 @@ bool RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
       assert(T < GroupSize && "Array overflow");
       TBS[T] = Number;
       if (++T == GroupSize) {
-        SpillPlacer->addLinks(makeArrayRef(TBS, T));
+        SpillPlacer.addLinks(makeArrayRef(TBS, T));
         T = 0;
       }
       continue;
@@ -1303,17 +1567,30 @@ bool RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
       BCS[B].Exit = SpillPlacement::PrefSpill;
 
     if (++B == GroupSize) {
-      SpillPlacer->addConstraints(makeArrayRef(BCS, B));
+      SpillPlacer.addConstraints(makeArrayRef(BCS, B));
       B = 0;
     }
   }
 
-  SpillPlacer->addConstraints(makeArrayRef(BCS, B));
-  SpillPlacer->addLinks(makeArrayRef(TBS, T));
+  SpillPlacer.addConstraints(makeArrayRef(BCS, B));
+  SpillPlacer.addLinks(makeArrayRef(TBS, T));
   return true;
 }
 
 bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
+  ProfilerHooks.beginSpillPlacement();
+  unsigned Iterations = 0;
+  bool Grown = growRegion(*SpillPlacer, Cand, Iterations);
+  for (; Iterations; --Iterations)
+    ProfilerHooks.recordGrowIteration();
+  ProfilerHooks.endSpillPlacement();
+  return Grown;
+}
+
+/// HKHAJ - growRegion on the given SpillPlacement, without profiler hooks so
+/// split workers can run it. Iterations counts the SpillPlacement iterations.
+bool RAGreedy::growRegion(SpillPlacement &SpillPlacer,
+                          GlobalSplitCandidate &Cand, unsigned &Iterations) {
   // Keep track of through blocks that have not been added to SpillPlacer.
   BitVector Todo = SA->getThroughBlocks();
   SmallVectorImpl<unsigned> &ActiveBlocks = Cand.ActiveBlocks;
@@ -1323,7 +1600,7 @@ bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
 #endif
 
   while (true) {
-    ArrayRef<unsigned> NewBundles = SpillPlacer->getRecentPositive();
+    ArrayRef<unsigned> NewBundles = SpillPlacer.getRecentPositive();
     // Find new through blocks in the periphery of PrefRegBundles.
     for (int i = 0, e = NewBundles.size(); i != e; ++i) {
       unsigned Bundle = NewBundles[i];
@@ -1350,16 +1627,17 @@ bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
     // through blocks prefer spilling when forming compact regions.
     auto NewBlocks = makeArrayRef(ActiveBlocks).slice(AddedTo);
     if (Cand.PhysReg) {
-      if (!addThroughConstraints(Cand.Intf, NewBlocks))
+      if (!addThroughConstraints(SpillPlacer, Cand.Intf, NewBlocks))
         return false;
     } else
       // Provide a strong negative bias on through blocks to prevent unwanted
       // liveness on loop backedges.
-      SpillPlacer->addPrefSpill(NewBlocks, /* Strong= */ true);
+      SpillPlacer.addPrefSpill(NewBlocks, /* Strong= */ true);
     AddedTo = ActiveBlocks.size();
 
     // Perhaps iterating can enable more bundles?
-    SpillPlacer->iterate();
+    SpillPlacer.iterate();
+    ++Iterations;
   }
   LLVM_DEBUG(dbgs() << ", v=" << Visited);
   return true;
@@ -1379,6 +1657,7 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
 
   // Compact regions don't correspond to any physreg.
   Cand.reset(IntfCache, 0);
+  ProfilerHooks.recordSplitCandidate();
 
   LLVM_DEBUG(dbgs() << "Compact region bundles");
 
@@ -1399,6 +1678,7 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
   }
 
   SpillPlacer->finish();
+  ProfilerHooks.recordBundlesActivated(Cand.LiveBundles.count());
 
   if (!Cand.LiveBundles.any()) {
     LLVM_DEBUG(dbgs() << ", none.\n");
@@ -1552,8 +1832,8 @@ bool RAGreedy::splitCanCauseLocalSpill(unsigned VirtRegToSplit,
 
   // Check if the local interval will find a non interfereing assignment.
   for (auto PhysReg : Order.getOrder()) {
-    if (!Matrix->checkInterference(Cand.Intf.first().getPrevIndex(),
-                                   Cand.Intf.last(), PhysReg))
+    if (!checkInterference(Cand.Intf.first().getPrevIndex(),
+                           Cand.Intf.last(), PhysReg))
       return false;
   }
 
@@ -1776,6 +2056,7 @@ void RAGreedy::splitAroundRegion(LiveRangeEdit &LREdit,
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
   DebugVars->splitRegister(Reg, LREdit.regs(), *LIS);
+  ProfilerHooks.recordSplit(RSP_Region, SA->getParent(), LREdit.regs());
 
   ExtraRegInfo.resize(MRI->getNumVirtRegs());
   unsigned OrigBlocks = SA->getNumLiveBlocks();
@@ -1837,6 +2118,8 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   unsigned NumCands = 0;
   BlockFrequency SpillCost = calcSpillCost();
   BlockFrequency BestCost;
+  ProfilerHooks.beginRegionSplit(VirtReg, SA->getNumThroughBlocks(),
+                                 SpillCost.getFrequency());
 
   // Check if we can split this live range around a compact region.
   bool HasCompact = calcCompactRegion(GlobalCand.front());
@@ -1856,6 +2139,8 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   unsigned BestCand =
       calculateRegionSplitCost(VirtReg, Order, BestCost, NumCands,
                                false /*IgnoreCSR*/, &CanCauseEvictionChain);
+  ProfilerHooks.endRegionSplit(BestCost.getFrequency(), HasCompact,
+                               BestCand != NoCand);
 
   // Split candidates with compact regions can cause a bad eviction sequence.
   // See splitCanCauseEvictionChain for detailed description of scenarios.
@@ -1873,12 +2158,194 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   return doRegionSplit(VirtReg, BestCand, HasCompact, NewVRegs);
 }
 
+/// HKHAJ - Solve the split candidates concurrently when -regalloc-split-threads
+/// asks for it and the live range is big enough to make up for the hand-off.
+bool RAGreedy::shouldSolveSplitsInParallel() const {
+  return SplitThreads > 1 &&
+         SA->getUseBlocks().size() + SA->getNumThroughBlocks() >=
+             SplitThreadsMinBlocks;
+}
+
+/// HKHAJ - Make the first NumWorkers split workers ready for the current
+/// function. A worker's SpillPlacement is a pass of its own: it gets a resolver
+/// onto the analyses the pass' SpillPlacement was computed from, and is run on
+/// the function like the pass manager would.
+void RAGreedy::setUpSplitWorkers(unsigned NumWorkers) {
+  if (!SplitPool)
+    SplitPool.reset(new ThreadPool(SplitThreads));
+
+  while (SplitWorkers.size() < NumWorkers) {
+    std::unique_ptr<SplitWorker> Worker(new SplitWorker());
+    Worker->SpillPlacer.reset(new SpillPlacement());
+    auto *Resolver =
+        new AnalysisResolver(SpillPlacer->getResolver()->getPMDataManager());
+    Resolver->addAnalysisImplsPair(
+        &MachineModuleInfoWrapperPass::ID,
+        &getAnalysis<MachineModuleInfoWrapperPass>());
+    Resolver->addAnalysisImplsPair(&EdgeBundles::ID,
+                                   &getAnalysis<EdgeBundles>());
+    Resolver->addAnalysisImplsPair(&MachineLoopInfo::ID,
+                                   &getAnalysis<MachineLoopInfo>());
+    Resolver->addAnalysisImplsPair(&MachineBlockFrequencyInfo::ID,
+                                   &getAnalysis<MachineBlockFrequencyInfo>());
+    // The pass owns and deletes its resolver.
+    Worker->SpillPlacer->setResolver(Resolver);
+    SplitWorkers.push_back(std::move(Worker));
+  }
+
+  for (; NumReadySplitWorkers < NumWorkers; ++NumReadySplitWorkers) {
+    SplitWorker &Worker = *SplitWorkers[NumReadySplitWorkers];
+    // SpillPlacement asserts that the last function's nodes were released.
+    Worker.SpillPlacer->releaseMemory();
+    static_cast<FunctionPass &>(*Worker.SpillPlacer)
+        .runOnFunction(MF->getFunction());
+    Worker.IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
+  }
+}
+
+/// HKHAJ - The part of the calculateRegionSplitCost loop that does not depend
+/// on the other candidates: the static cost, and if it is below BestCost the
+/// region grown by the SpillPlacement. Runs on a SplitPool thread, so it only
+/// touches the worker and S.
+void RAGreedy::solveSplitCandidate(SplitWorker &Worker, unsigned PhysReg,
+                                   BlockFrequency BestCost, SplitSolution &S) {
+  GlobalSplitCandidate &Cand = Worker.Cand;
+  Cand.reset(Worker.IntfCache, PhysReg);
+  S.Grown = false;
+  S.GrowIterations = 0;
+
+  Worker.SpillPlacer->prepare(Cand.LiveBundles);
+  S.Constrained = addSplitConstraints(*Worker.SpillPlacer, S.Constraints,
+                                      Cand.Intf, S.StaticCost);
+  if (!S.Constrained || S.StaticCost >= BestCost)
+    return;
+  if (!growRegion(*Worker.SpillPlacer, Cand, S.GrowIterations))
+    return;
+  Worker.SpillPlacer->finish();
+  S.Grown = true;
+  S.LiveBundles = Cand.LiveBundles;
+  S.ActiveBlocks = Cand.ActiveBlocks;
+}
+
+/// HKHAJ - Solve the spill placement of every candidate in PhysRegs on the
+/// SplitPool, into SplitSolutions.
+///
+/// The solutions are those of the sequential loop: a candidate's solution only
+/// depends on its interference and the live range, SpillPlacement::prepare
+/// resets everything else. The sequential loop only grows candidates whose
+/// static cost is below the BestCost of the moment, which never goes up, so
+/// growing everything below the initial BestCost covers them all.
+void RAGreedy::solveSplitCandidates(ArrayRef<unsigned> PhysRegs,
+                                    BlockFrequency BestCost) {
+  // InsertPointAnalysis computes the split points of a block on first use.
+  // Do it now, the workers must only read them.
+  for (const SplitAnalysis::BlockInfo &BI : SA->getUseBlocks()) {
+    SA->getFirstSplitPoint(BI.MBB->getNumber());
+    SA->getLastSplitPoint(BI.MBB->getNumber());
+  }
+  for (unsigned Number : SA->getThroughBlocks().set_bits()) {
+    SA->getFirstSplitPoint(Number);
+    SA->getLastSplitPoint(Number);
+  }
+  // InterferenceCache::Entry::reset asks LiveIntervals for the fixed
+  // interference of each unit, which computes missing regunit ranges through
+  // its shared LiveRangeCalc. Compute them all now.
+  for (unsigned PhysReg : PhysRegs)
+    for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units)
+      LIS->getRegUnit(*Units);
+
+  unsigned NumWorkers = std::min<size_t>(SplitThreads, PhysRegs.size());
+  setUpSplitWorkers(NumWorkers);
+  if (SplitSolutions.size() < PhysRegs.size())
+    SplitSolutions.resize(PhysRegs.size());
+
+  std::atomic<unsigned> NextCand(0);
+  for (unsigned i = 0; i != NumWorkers; ++i) {
+    SplitWorker &Worker = *SplitWorkers[i];
+    SplitPool->async([&, BestCost] {
+      for (unsigned C = NextCand++; C < PhysRegs.size(); C = NextCand++)
+        solveSplitCandidate(Worker, PhysRegs[C], BestCost, SplitSolutions[C]);
+      // Release the cache entry, the next function clears the cache.
+      Worker.Cand.Intf.setPhysReg(Worker.IntfCache, 0);
+    });
+  }
+  SplitPool->wait();
+}
+
+/// HKHAJ - Take over the solution S of Cand, which the sequential loop would
+/// have grown now. Returns false if growRegion failed.
+bool RAGreedy::adoptSplitSolution(GlobalSplitCandidate &Cand,
+                                  SplitSolution &S) {
+  for (unsigned i = 0; i != S.GrowIterations; ++i)
+    ProfilerHooks.recordGrowIteration();
+  if (!S.Grown)
+    return false;
+  Cand.LiveBundles = S.LiveBundles;
+  Cand.ActiveBlocks = S.ActiveBlocks;
+  // calcGlobalSplitCost reads the candidate's use block constraints.
+  SplitConstraints = S.Constraints;
+  return true;
+}
+
+/// HKHAJ - With -regalloc-split-threads-verify, evaluate Cand one at a time on
+/// the pass' SpillPlacement, like the sequential loop would with its current
+/// BestCost, and check the concurrent solution S against it.
+void RAGreedy::verifySplitSolution(GlobalSplitCandidate &Cand,
+                                   const SplitSolution &S,
+                                   BlockFrequency BestCost) {
+  SpillPlacer->prepare(Cand.LiveBundles);
+  BlockFrequency Cost;
+  bool Same = addSplitConstraints(Cand.Intf, Cost) == S.Constrained;
+  if (Same && S.Constrained) {
+    Same = Cost == S.StaticCost &&
+           SplitConstraints.size() == S.Constraints.size();
+    for (unsigned i = 0; Same && i != SplitConstraints.size(); ++i) {
+      const SpillPlacement::BlockConstraint &BC = SplitConstraints[i];
+      const SpillPlacement::BlockConstraint &SBC = S.Constraints[i];
+      Same = BC.Number == SBC.Number && BC.Entry == SBC.Entry &&
+             BC.Exit == SBC.Exit && BC.ChangesValue == SBC.ChangesValue;
+    }
+  }
+  // The sequential loop only grows candidates below its current BestCost.
+  if (Same && S.Constrained && Cost < BestCost) {
+    unsigned Iterations = 0;
+    bool Grown = growRegion(*SpillPlacer, Cand, Iterations);
+    Same = Grown == S.Grown && Iterations == S.GrowIterations;
+    if (Same && Grown) {
+      SpillPlacer->finish();
+      Same = Cand.LiveBundles == S.LiveBundles &&
+             Cand.ActiveBlocks == S.ActiveBlocks;
+    }
+  }
+  if (!Same)
+    report_fatal_error("concurrent split solution of " +
+                       Twine(TRI->getName(Cand.PhysReg)) +
+                       " differs from the sequential one");
+}
+
 unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
                                             AllocationOrder &Order,
                                             BlockFrequency &BestCost,
                                             unsigned &NumCands, bool IgnoreCSR,
                                             bool *CanCauseEvictionChain) {
   unsigned BestCand = NoCand;
+
+  // HKHAJ - with -regalloc-split-threads the spill placements are solved up
+  // front, concurrently, and the loop below picks from the solutions in
+  // allocation order exactly like it picks from its own.
+  SplitSolution *Solutions = nullptr;
+  if (shouldSolveSplitsInParallel()) {
+    SmallVector<unsigned, 32> PhysRegs;
+    Order.rewind();
+    while (unsigned PhysReg = Order.next())
+      if (!IgnoreCSR || !isUnusedCalleeSavedReg(PhysReg))
+        PhysRegs.push_back(PhysReg);
+    ProfilerHooks.beginSpillPlacement();
+    solveSplitCandidates(PhysRegs, BestCost);
+    ProfilerHooks.endSpillPlacement();
+    Solutions = SplitSolutions.data();
+  }
+
   Order.rewind();
   while (unsigned PhysReg = Order.next()) {
     if (IgnoreCSR && isUnusedCalleeSavedReg(PhysReg))
@@ -1908,10 +2375,18 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
       GlobalCand.resize(NumCands+1);
     GlobalSplitCandidate &Cand = GlobalCand[NumCands];
     Cand.reset(IntfCache, PhysReg);
+    ProfilerHooks.recordSplitCandidate();
 
-    SpillPlacer->prepare(Cand.LiveBundles);
+    SplitSolution *Solution = Solutions ? Solutions++ : nullptr;
+    if (Solution && VerifySplitThreads)
+      verifySplitSolution(Cand, *Solution, BestCost);
     BlockFrequency Cost;
-    if (!addSplitConstraints(Cand.Intf, Cost)) {
+    if (Solution)
+      Cost = Solution->StaticCost;
+    else
+      SpillPlacer->prepare(Cand.LiveBundles);
+    if (Solution ? !Solution->Constrained
+                 : !addSplitConstraints(Cand.Intf, Cost)) {
       LLVM_DEBUG(dbgs() << printReg(PhysReg, TRI) << "\tno positive bundles\n");
       continue;
     }
@@ -1927,12 +2402,14 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
       });
       continue;
     }
-    if (!growRegion(Cand)) {
+    if (Solution ? !adoptSplitSolution(Cand, *Solution) : !growRegion(Cand)) {
       LLVM_DEBUG(dbgs() << ", cannot spill all interferences.\n");
       continue;
     }
 
-    SpillPlacer->finish();
+    if (!Solution)
+      SpillPlacer->finish();
+    ProfilerHooks.recordBundlesActivated(Cand.LiveBundles.count());
 
     // No live bundles, defer to splitSingleBlocks().
     if (!Cand.LiveBundles.any()) {
@@ -2043,6 +2520,7 @@ unsigned RAGreedy::tryBlockSplit(LiveInterval &VirtReg, AllocationOrder &Order,
 
   // Tell LiveDebugVariables about the new ranges.
   DebugVars->splitRegister(Reg, LREdit.regs(), *LIS);
+  ProfilerHooks.recordSplit(RSP_Block, VirtReg, LREdit.regs());
 
   ExtraRegInfo.resize(MRI->getNumVirtRegs());
 
@@ -2136,6 +2614,7 @@ RAGreedy::tryInstructionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
   DebugVars->splitRegister(VirtReg.reg, LREdit.regs(), *LIS);
+  ProfilerHooks.recordSplit(RSP_Instruction, VirtReg, LREdit.regs());
   ExtraRegInfo.resize(MRI->getNumVirtRegs());
 
   // Assign all new registers to RS_Spill. This was the last chance.
@@ -2152,12 +2631,17 @@ RAGreedy::tryInstructionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
 ///
 /// GapWeight[i] represents the gap between UseSlots[i] and UseSlots[i+1].
 ///
+/// HKHAJ - The gaps are found with GapKernel over GapBoundaryKeys and
+/// GapBaseKeys, which tryLocalSplit sets up once for all candidate PhysRegs.
+///
 void RAGreedy::calcGapWeights(unsigned PhysReg,
                               SmallVectorImpl<float> &GapWeight) {
   assert(SA->getUseBlocks().size() == 1 && "Not a local interval");
   const SplitAnalysis::BlockInfo &BI = SA->getUseBlocks().front();
   ArrayRef<SlotIndex> Uses = SA->getUseSlots();
   const unsigned NumGaps = Uses.size()-1;
+  assert(GapBoundaryKeys.size() == NumGaps && "gap keys not set up!");
+  const SlotIndex KeyBase = Uses.front();
 
   // Start and end points for the interference check.
   SlotIndex StartIdx =
@@ -2169,8 +2653,12 @@ void RAGreedy::calcGapWeights(unsigned PhysReg,
 
   // Add interference from each overlapping register.
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
-    if (!Matrix->query(const_cast<LiveInterval&>(SA->getParent()), *Units)
-          .checkInterference())
+    unsigned Visited = segmentsVisited();
+    bool HasIntf =
+        Matrix->query(const_cast<LiveInterval &>(SA->getParent()), *Units)
+            .checkInterference();
+    ProfilerHooks.recordQuery(PhysReg, segmentsVisited() - Visited);
+    if (!HasIntf)
       continue;
 
     // We know that VirtReg is a continuous interval from FirstInstr to
@@ -2184,19 +2672,19 @@ void RAGreedy::calcGapWeights(unsigned PhysReg,
       Matrix->getLiveUnions()[*Units] .find(StartIdx);
     for (unsigned Gap = 0; IntI.valid() && IntI.start() < StopIdx; ++IntI) {
       // Skip the gaps before IntI.
-      while (Uses[Gap+1].getBoundaryIndex() < IntI.start())
-        if (++Gap == NumGaps)
-          break;
+      Gap = GapKernel.findNotBelow(GapBoundaryKeys.data(), Gap, NumGaps,
+                                   KeyBase.distance(IntI.start()));
       if (Gap == NumGaps)
         break;
 
-      // Update the gaps covered by IntI.
+      // Update the gaps covered by IntI, up to the first one whose end is
+      // past IntI.
       const float weight = IntI.value()->weight;
-      for (; Gap != NumGaps; ++Gap) {
-        GapWeight[Gap] = std::max(GapWeight[Gap], weight);
-        if (Uses[Gap+1].getBaseIndex() >= IntI.stop())
-          break;
-      }
+      unsigned Last = GapKernel.findNotBelow(GapBaseKeys.data(), Gap, NumGaps,
+                                             KeyBase.distance(IntI.stop()));
+      GapKernel.raise(GapWeight.data(), Gap, std::min(Last + 1, NumGaps),
+                      weight);
+      Gap = Last;
       if (Gap == NumGaps)
         break;
     }
@@ -2210,17 +2698,16 @@ void RAGreedy::calcGapWeights(unsigned PhysReg,
 
     // Same loop as above. Mark any overlapped gaps as HUGE_VALF.
     for (unsigned Gap = 0; I != E && I->start < StopIdx; ++I) {
-      while (Uses[Gap+1].getBoundaryIndex() < I->start)
-        if (++Gap == NumGaps)
-          break;
+      Gap = GapKernel.findNotBelow(GapBoundaryKeys.data(), Gap, NumGaps,
+                                   KeyBase.distance(I->start));
       if (Gap == NumGaps)
         break;
 
-      for (; Gap != NumGaps; ++Gap) {
-        GapWeight[Gap] = huge_valf;
-        if (Uses[Gap+1].getBaseIndex() >= I->end)
-          break;
-      }
+      unsigned Last = GapKernel.findNotBelow(GapBaseKeys.data(), Gap, NumGaps,
+                                             KeyBase.distance(I->end));
+      GapKernel.raise(GapWeight.data(), Gap, std::min(Last + 1, NumGaps),
+                      huge_valf);
+      Gap = Last;
       if (Gap == NumGaps)
         break;
     }
@@ -2319,6 +2806,14 @@ unsigned RAGreedy::tryLocalSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     (1.0f / MBFI->getEntryFreq());
   SmallVector<float, 8> GapWeight;
 
+  // HKHAJ - Flatten the gap bounds for calcGapWeights.
+  GapBoundaryKeys.resize(NumGaps);
+  GapBaseKeys.resize(NumGaps);
+  for (unsigned i = 0; i != NumGaps; ++i) {
+    GapBoundaryKeys[i] = Uses.front().distance(Uses[i+1].getBoundaryIndex());
+    GapBaseKeys[i] = Uses.front().distance(Uses[i+1].getBaseIndex());
+  }
+
   Order.rewind();
   while (unsigned PhysReg = Order.next()) {
     // Keep track of the largest spill weight that would need to be evicted in
@@ -2393,11 +2888,8 @@ unsigned RAGreedy::tryLocalSplit(LiveInterval &VirtReg, AllocationOrder &Order,
         if (++SplitBefore < SplitAfter) {
           LLVM_DEBUG(dbgs() << " shrink\n");
           // Recompute the max when necessary.
-          if (GapWeight[SplitBefore - 1] >= MaxGap) {
-            MaxGap = GapWeight[SplitBefore];
-            for (unsigned i = SplitBefore + 1; i != SplitAfter; ++i)
-              MaxGap = std::max(MaxGap, GapWeight[i]);
-          }
+          if (GapWeight[SplitBefore - 1] >= MaxGap)
+            MaxGap = GapKernel.max(GapWeight.data(), SplitBefore, SplitAfter);
           continue;
         }
         MaxGap = 0;
@@ -2432,6 +2924,7 @@ unsigned RAGreedy::tryLocalSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
   DebugVars->splitRegister(VirtReg.reg, LREdit.regs(), *LIS);
+  ProfilerHooks.recordSplit(RSP_Local, VirtReg, LREdit.regs());
 
   // If the new range has the same number of instructions as before, mark it as
   // RS_Split2 so the next split will be forced to make progress. Otherwise,
@@ -2474,9 +2967,14 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
                        TimerGroupDescription, TimePassesIsEnabled);
     SA->analyze(&VirtReg);
     unsigned PhysReg = tryLocalSplit(VirtReg, Order, NewVRegs);
-    if (PhysReg || !NewVRegs.empty())
+    if (PhysReg || !NewVRegs.empty()) {
+      recordEvent(RAE_LocalSplit, VirtReg, PhysReg);
       return PhysReg;
-    return tryInstructionSplit(VirtReg, Order, NewVRegs);
+    }
+    PhysReg = tryInstructionSplit(VirtReg, Order, NewVRegs);
+    if (PhysReg || !NewVRegs.empty())
+      recordEvent(RAE_InstructionSplit, VirtReg, PhysReg);
+    return PhysReg;
   }
 
   NamedRegionTimer T("global_split", "Global Splitting", TimerGroupName,
@@ -2500,12 +2998,17 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   // straight to single block splitting.
   if (getStage(VirtReg) < RS_Split2) {
     unsigned PhysReg = tryRegionSplit(VirtReg, Order, NewVRegs);
-    if (PhysReg || !NewVRegs.empty())
+    if (PhysReg || !NewVRegs.empty()) {
+      recordEvent(RAE_RegionSplit, VirtReg, PhysReg);
       return PhysReg;
+    }
   }
 
   // Then isolate blocks.
-  return tryBlockSplit(VirtReg, Order, NewVRegs);
+  unsigned PhysReg = tryBlockSplit(VirtReg, Order, NewVRegs);
+  if (PhysReg || !NewVRegs.empty())
+    recordEvent(RAE_BlockSplit, VirtReg, PhysReg);
+  return PhysReg;
 }
 
 //===----------------------------------------------------------------------===//
@@ -2537,12 +3040,16 @@ RAGreedy::mayRecolorAllInterferences(unsigned PhysReg, LiveInterval &VirtReg,
 
   for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
     LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
-    // If there is LastChanceRecoloringMaxInterference or more interferences,
-    // chances are one would not be recolorable.
-    if (Q.collectInterferingVRegs(LastChanceRecoloringMaxInterference) >=
-        LastChanceRecoloringMaxInterference && !ExhaustiveSearch) {
+    unsigned Visited = segmentsVisited();
+    unsigned NumIntf =
+        Q.collectInterferingVRegs(LCRMaxInterference);
+    ProfilerHooks.recordQuery(PhysReg, segmentsVisited() - Visited);
+    // If there is LCRMaxInterference or more interferences, chances are one
+    // would not be recolorable.
+    if (NumIntf >= LCRMaxInterference && !ExhaustiveSearch) {
       LLVM_DEBUG(dbgs() << "Early abort: too many interferences.\n");
       CutOffInfo |= CO_Interf;
+      ProfilerHooks.recordLCRCutoff(false);
       return false;
     }
     for (unsigned i = Q.interferingVRegs().size(); i; --i) {
@@ -2613,13 +3120,16 @@ unsigned RAGreedy::tryLastChanceRecoloring(LiveInterval &VirtReg,
   // Ranges must be Done.
   assert((getStage(VirtReg) >= RS_Done || !VirtReg.isSpillable()) &&
          "Last chance recoloring should really be last chance");
-  // Set the max depth to LastChanceRecoloringMaxDepth.
+  ProfilerHooks.recordLCRDepth(Depth);
+  // Set the max depth to LCRMaxDepth, i.e. LastChanceRecoloringMaxDepth unless
+  // the recoloring time budget of the function has been exceeded.
   // We may want to reconsider that if we end up with a too large search space
   // for target with hundreds of registers.
   // Indeed, in that case we may want to cut the search space earlier.
-  if (Depth >= LastChanceRecoloringMaxDepth && !ExhaustiveSearch) {
+  if (Depth >= LCRMaxDepth && !ExhaustiveSearch) {
     LLVM_DEBUG(dbgs() << "Abort because max depth has been reached.\n");
     CutOffInfo |= CO_Depth;
+    ProfilerHooks.recordLCRCutoff(true);
     return ~0u;
   }
 
@@ -2638,12 +3148,13 @@ unsigned RAGreedy::tryLastChanceRecoloring(LiveInterval &VirtReg,
   while (unsigned PhysReg = Order.next()) {
     LLVM_DEBUG(dbgs() << "Try to assign: " << VirtReg << " to "
                       << printReg(PhysReg, TRI) << '\n');
+    ProfilerHooks.recordLCRCandidate();
     RecoloringCandidates.clear();
     VirtRegToPhysReg.clear();
     CurrentNewVRegs.clear();
 
     // It is only possible to recolor virtual register interference.
-    if (Matrix->checkInterference(VirtReg, PhysReg) >
+    if (checkInterference(VirtReg, PhysReg) >
         LiveRegMatrix::IK_VirtReg) {
       LLVM_DEBUG(
           dbgs() << "Some interferences are not with virtual registers.\n");
@@ -2662,7 +3173,7 @@ unsigned RAGreedy::tryLastChanceRecoloring(LiveInterval &VirtReg,
     // RecoloringCandidates contains all the virtual registers that interfer
     // with VirtReg on PhysReg (or one of its aliases).
     // Enqueue them for recoloring and perform the actual recoloring.
-    PQueue RecoloringQueue;
+    PQueue RecoloringQueue(Queue.getKind());
     for (SmallLISet::iterator It = RecoloringCandidates.begin(),
                               EndIt = RecoloringCandidates.end();
          It != EndIt; ++It) {
@@ -2731,6 +3242,74 @@ unsigned RAGreedy::tryLastChanceRecoloring(LiveInterval &VirtReg,
   return ~0u;
 }
 
+/// HKHAJ - runLastChanceRecoloring - tryLastChanceRecoloring with the
+/// recoloring time budget of the function.
+/// Nested recoloring (\p Depth > 0) is forwarded as is. An outermost call is
+/// timed and reported to the profiler; once the function's recoloring time
+/// exceeds another multiple of -lcr-time-budget-us the depth and interference
+/// limits are halved for the rest of the function.
+/// Lowered limits only trade recoloring quality for compile time: when an
+/// attempt under them fails on a cutoff, it is redone with the full limits so
+/// that they never turn into a register allocation failure.
+unsigned RAGreedy::runLastChanceRecoloring(LiveInterval &VirtReg,
+                                           AllocationOrder &Order,
+                                           SmallVectorImpl<unsigned> &NewVRegs,
+                                           SmallVirtRegSet &FixedRegisters,
+                                           unsigned Depth) {
+  if (Depth)
+    return tryLastChanceRecoloring(VirtReg, Order, NewVRegs, FixedRegisters,
+                                   Depth);
+
+  auto Start = std::chrono::steady_clock::now();
+  ProfilerHooks.beginLastChanceRecoloring(VirtReg, LCRMaxDepth,
+                                          LCRMaxInterference);
+  bool Lowered = LCRMaxDepth != LastChanceRecoloringMaxDepth ||
+                 LCRMaxInterference != LastChanceRecoloringMaxInterference;
+  // A failed attempt leaves VirtReg in FixedRegisters.
+  SmallVirtRegSet SaveFixedRegisters;
+  if (Lowered)
+    SaveFixedRegisters = FixedRegisters;
+  unsigned PhysReg =
+      tryLastChanceRecoloring(VirtReg, Order, NewVRegs, FixedRegisters, 0);
+  bool Retried = PhysReg == ~0u && Lowered && CutOffInfo != CO_None;
+  if (Retried) {
+    LLVM_DEBUG(dbgs() << "Retry last chance recoloring with full limits.\n");
+    unsigned SaveMaxDepth = LCRMaxDepth;
+    unsigned SaveMaxInterference = LCRMaxInterference;
+    LCRMaxDepth = LastChanceRecoloringMaxDepth;
+    LCRMaxInterference = LastChanceRecoloringMaxInterference;
+    FixedRegisters = SaveFixedRegisters;
+    CutOffInfo = CO_None;
+    PhysReg =
+        tryLastChanceRecoloring(VirtReg, Order, NewVRegs, FixedRegisters, 0);
+    LCRMaxDepth = SaveMaxDepth;
+    LCRMaxInterference = SaveMaxInterference;
+  }
+  std::chrono::nanoseconds Elapsed = std::chrono::steady_clock::now() - Start;
+  ProfilerHooks.endLastChanceRecoloring(PhysReg != ~0u, Retried,
+                                        Elapsed.count());
+
+  LCRTime += Elapsed;
+  if (!LastChanceRecoloringTimeBudget || ExhaustiveSearch)
+    return PhysReg;
+  std::chrono::microseconds Budget(LastChanceRecoloringTimeBudget);
+  if (LCRTime >= Budget * (LCRBudgetSteps + 1)) {
+    // Skip the steps a single slow invocation may have covered.
+    LCRBudgetSteps = LCRTime / Budget;
+    if (LCRMaxDepth > 1)
+      LCRMaxDepth /= 2;
+    // With a limit of 1 every interference would be a cutoff.
+    if (LCRMaxInterference > 2)
+      LCRMaxInterference = std::max(2u, LCRMaxInterference / 2);
+    LLVM_DEBUG(dbgs() << "Recoloring budget exceeded, lowering limits to depth "
+                      << LCRMaxDepth << ", interference " << LCRMaxInterference
+                      << '\n');
+    ProfilerHooks.recordLCRLimits(LCRTime.count(), LCRMaxDepth,
+                                  LCRMaxInterference);
+  }
+  return PhysReg;
+}
+
 /// tryRecoloringCandidates - Try to assign a new color to every register
 /// in \RecoloringQueue.
 /// \p NewRegs will contain any new virtual register created during the
@@ -2780,6 +3359,8 @@ unsigned RAGreedy::selectOrSplit(LiveInterval &VirtReg,
   LLVMContext &Ctx = MF->getFunction().getContext();
   SmallVirtRegSet FixedRegisters;
   unsigned Reg = selectOrSplitImpl(VirtReg, NewVRegs, FixedRegisters);
+  if (Reg && Reg != ~0U)
+    ProfilerHooks.recordAssignment(VirtReg, Reg);
   if (Reg == ~0U && (CutOffInfo != CO_None)) {
     uint8_t CutOffEncountered = CutOffInfo & (CO_Depth | CO_Interf);
     if (CutOffEncountered == CO_Depth)
@@ -2813,11 +3394,19 @@ unsigned RAGreedy::tryAssignCSRFirstTime(LiveInterval &VirtReg,
     // We choose spill over using the CSR for the first time if the spill cost
     // is lower than CSRCost.
     SA->analyze(&VirtReg);
-    if (calcSpillCost() >= CSRCost)
+    BlockFrequency SpillCost = calcSpillCost();
+    if (SpillCost >= CSRCost) {
+      ProfilerHooks.recordCSRDecision(
+          VirtReg, PhysReg, RS_Spill, RegAllocCSRDecision::CSA_Spill,
+          SpillCost.getFrequency(), RegAllocCSRDecision::CSR_Use);
       return PhysReg;
+    }
 
     // We are going to spill, set CostPerUseLimit to 1 to make sure that
     // we will not use a callee-saved register in tryEvict.
+    ProfilerHooks.recordCSRDecision(
+        VirtReg, PhysReg, RS_Spill, RegAllocCSRDecision::CSA_Spill,
+        SpillCost.getFrequency(), RegAllocCSRDecision::CSR_Spill);
     CostPerUseLimit = 1;
     return 0;
   }
@@ -2829,14 +3418,26 @@ unsigned RAGreedy::tryAssignCSRFirstTime(LiveInterval &VirtReg,
     BlockFrequency BestCost = CSRCost; // Don't modify CSRCost.
     unsigned BestCand = calculateRegionSplitCost(VirtReg, Order, BestCost,
                                                  NumCands, true /*IgnoreCSR*/);
-    if (BestCand == NoCand)
+    if (BestCand == NoCand) {
       // Use the CSR if we can't find a region split below CSRCost.
+      // HKHAJ - BestCost is still CSRCost then, no split was priced.
+      ProfilerHooks.recordCSRDecision(
+          VirtReg, PhysReg, getStage(VirtReg), RegAllocCSRDecision::CSA_Split,
+          RegAllocCSRDecision::NoAltCost, RegAllocCSRDecision::CSR_Use);
       return PhysReg;
+    }
 
     // Perform the actual pre-splitting.
+    ProfilerHooks.recordCSRDecision(
+        VirtReg, PhysReg, getStage(VirtReg), RegAllocCSRDecision::CSA_Split,
+        BestCost.getFrequency(), RegAllocCSRDecision::CSR_Split);
     doRegionSplit(VirtReg, BestCand, false/*HasCompact*/, NewVRegs);
     return 0;
   }
+  ProfilerHooks.recordCSRDecision(VirtReg, PhysReg, getStage(VirtReg),
+                                  RegAllocCSRDecision::CSA_None,
+                                  RegAllocCSRDecision::NoAltCost,
+                                  RegAllocCSRDecision::CSR_Use);
   return PhysReg;
 }
 
@@ -2948,7 +3549,7 @@ void RAGreedy::tryHintRecoloring(LiveInterval &VirtReg) {
     // Check that the new color matches the register class constraints and
     // that it is free for this live range.
     if (CurrPhys != PhysReg && (!MRI->getRegClass(Reg)->contains(PhysReg) ||
-                                Matrix->checkInterference(LI, PhysReg)))
+                                checkInterference(LI, PhysReg)))
       continue;
 
     LLVM_DEBUG(dbgs() << printReg(Reg, TRI) << '(' << printReg(CurrPhys, TRI)
@@ -2977,6 +3578,8 @@ void RAGreedy::tryHintRecoloring(LiveInterval &VirtReg) {
       // Recolor the live-range.
       Matrix->unassign(LI);
       Matrix->assign(LI, PhysReg);
+      recordEvent(RAE_HintRecoloring, LI, PhysReg);
+      ProfilerHooks.recordHintRecoloring();
     }
     // Push all copy-related live-ranges to keep reconciling the broken
     // hints.
@@ -3043,6 +3646,7 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
   // First try assigning a free register.
   AllocationOrder Order(VirtReg.reg, *VRM, RegClassInfo, Matrix);
   if (unsigned PhysReg = tryAssign(VirtReg, Order, NewVRegs, FixedRegisters)) {
+    recordEvent(RAE_Assign, VirtReg, PhysReg);
     // If VirtReg got an assignment, the eviction info is no longre relevant.
     LastEvicted.clearEvicteeInfo(VirtReg.reg);
     // When NewVRegs is not empty, we may have made decisions such as evicting
@@ -3094,7 +3698,7 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
     setStage(VirtReg, RS_Split);
     LLVM_DEBUG(dbgs() << "wait for second round\n");
     NewVRegs.push_back(VirtReg.reg);
-    vRegsMarkedToSplit.insert(VirtReg.reg);
+    ProfilerHooks.markSplit(VirtReg.reg);
     return 0;
   }
 
@@ -3111,9 +3715,13 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
 
   // If we couldn't allocate a register from spilling, there is probably some
   // invalid inline assembly. The base class will report it.
-  if (Stage >= RS_Done || !VirtReg.isSpillable())
-    return tryLastChanceRecoloring(VirtReg, Order, NewVRegs, FixedRegisters,
-                                   Depth);
+  if (Stage >= RS_Done || !VirtReg.isSpillable()) {
+    unsigned PhysReg = runLastChanceRecoloring(VirtReg, Order, NewVRegs,
+                                               FixedRegisters, Depth);
+    recordEvent(RAE_LastChanceRecoloring, VirtReg,
+                PhysReg == ~0u ? 0 : PhysReg);
+    return PhysReg;
+  }
 
   // Finally spill VirtReg itself.
   if (EnableDeferredSpilling && getStage(VirtReg) < RS_Memory) {
@@ -3122,13 +3730,16 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
     // We would need a deep integration with the spiller to do the
     // right thing here. Anyway, that is still good for early testing.
     setStage(VirtReg, RS_Memory);
+    recordEvent(RAE_Spill, VirtReg, 0);
     LLVM_DEBUG(dbgs() << "Do as if this register is in memory\n");
     NewVRegs.push_back(VirtReg.reg);
   } else {
     NamedRegionTimer T("spill", "Spiller", TimerGroupName,
                        TimerGroupDescription, TimePassesIsEnabled);
+    recordEvent(RAE_Spill, VirtReg, 0);
     LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this, &DeadRemats);
     spiller().spill(LRE);
+    ProfilerHooks.recordSpill(VirtReg, LRE.regs());
     setStage(NewVRegs.begin(), NewVRegs.end(), RS_Done);
 
     // Tell LiveDebugVariables about the new ranges. Ranges not being covered by
@@ -3200,6 +3811,10 @@ void RAGreedy::reportNumberOfSplillsReloads(MachineLoop *L, unsigned &Reloads,
   if (Reloads || FoldedReloads || Spills || FoldedSpills) {
     using namespace ore;
 
+    ProfilerHooks.recordLoopSpills(
+        *L, MBFI->getBlockFreqRelativeToEntryBlock(L->getHeader()), Reloads,
+        FoldedReloads, Spills, FoldedSpills);
+
     ORE->emit([&]() {
       MachineOptimizationRemarkMissed R(DEBUG_TYPE, "LoopSpillReload",
                                         L->getStartLoc(), L->getHeader());
@@ -3254,7 +3869,10 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
 
   initializeCSRCost();
 
-  calculateSpillWeightsAndHints(*LIS, mf, VRM, *Loops, *MBFI);
+  {
+    TimeTraceScope TimeScope("RegAllocSpillWeights", MF->getName());
+    calculateSpillWeightsAndHints(*LIS, mf, VRM, *Loops, *MBFI);
+  }
 
   LLVM_DEBUG(LIS->dump());
 
@@ -3263,46 +3881,50 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   ExtraRegInfo.clear();
   ExtraRegInfo.resize(MRI->getNumVirtRegs());
   NextCascade = 1;
+  LCRMaxDepth = LastChanceRecoloringMaxDepth;
+  LCRMaxInterference = LastChanceRecoloringMaxInterference;
+  LCRTime = std::chrono::nanoseconds::zero();
+  LCRBudgetSteps = 0;
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
+  NumReadySplitWorkers = 0;
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
   LastEvicted.clear();
 
-  // HKHAJ
-  auto* profiler = new RegAllocProfiler(MF,TRI,VRM,MRI,&vRegsMarkedToSplit);
-  profiler->init();
-  vRegsMarkedToSplit.clear();
-  // HKHAJ 10/22 - checking original vReg class types to make sure that
-  // floating point variables are not being allocated to integer registers
-  std::vector<Register> origVRegs = profiler->originalVRegs();
-
-  allocatePhysRegs();
-  tryHintsRecoloring();
-  postOptimization();
-
-  
-  profiler->computeStats();
-
-  // HKHAJ - 11/10 
-  // Comparing split-marked vregs against the allocation status of the vReg - they should match or else
-  // bug 
-  /*
-  for (auto reg : vRegsMarkedToSplit) {
-
-    errs() << "Checking vreg: " << Register::virtReg2Index(reg) << '\n';
-    assert (!profiler->getRegAllocation(reg) && "found a vreg that was split-marked but marked as allocated!");
-  } 
-  */
-
-  //profiler->dumpProfilerStats();
-  // 10/31 - added map dump for all original vRegs
-  //profiler->dumpOrigVRegMappings();
-  profiler->dumpProfStatsToFile("regalloc_dump_bw.txt");
-  // END HKHAJ
-  delete profiler;
-
-
+  // HKHAJ - the original vReg set has to be captured before allocatePhysRegs()
+  // grows MRI with split/spill products
+  ProfilerHooks.beginFunction(MF, TRI, VRM, MRI, LIS);
+  ProfilerHooks.trackInterference(TRI, IntfCache);
+  ProfilerHooks.trackSpillCost(MF, VRM, MRI, MBFI, RegAllocProfileSchedCost);
+  ProfilerHooks.trackHints(MF, VRM, MRI, MBFI);
+  ProfilerHooks.trackCSRCost(CSRCost.getFrequency());
+
+  {
+    TimeTraceScope TimeScope("RegAllocPhysRegs", MF->getName());
+    ProfilerHooks.beginPhase(RPP_AllocatePhysRegs);
+    allocatePhysRegs();
+    ProfilerHooks.endPhase(RPP_AllocatePhysRegs);
+  }
+  {
+    TimeTraceScope TimeScope("RegAllocHintsRecoloring", MF->getName());
+    ProfilerHooks.beginHintsRecoloring(SetOfBrokenHints.size());
+    ProfilerHooks.beginPhase(RPP_HintsRecoloring);
+    tryHintsRecoloring();
+    ProfilerHooks.endPhase(RPP_HintsRecoloring);
+    ProfilerHooks.endHintsRecoloring();
+  }
+  {
+    TimeTraceScope TimeScope("RegAllocPostOptimization", MF->getName());
+    ProfilerHooks.beginPhase(RPP_PostOptimization);
+    postOptimization();
+    ProfilerHooks.endPhase(RPP_PostOptimization);
+  }
+
+  // HKHAJ - the per-loop spill counts go into this function's profile
   reportNumberOfSplillsReloads();
+  ProfilerHooks.countUsedCSRs(MRI, Matrix);
+
+  ProfilerHooks.endFunction();
 
   releaseMemory();
   return true;
@@ -0,0 +1,65 @@
+#include "llvm/CodeGen/RegAllocHintStats.h"
+
+using namespace llvm;
+
+void RegAllocHintStats::clear(const MachineFunction* MF, const VirtRegMap* VRM,
+                              const MachineRegisterInfo* MRI,
+                              const MachineBlockFrequencyInfo* MBFI) {
+  this->MF = MF;
+  this->VRM = VRM;
+  this->MRI = MRI;
+  this->MBFI = MBFI;
+  assigned.clear();
+  assigned.resize(MRI->getNumVirtRegs());
+  hintedVRegs = satisfiedVRegs = 0;
+  recoloringCandidates = recoloredVRegs = 0;
+  beforeRecoloring = afterRecoloring = RegAllocCopyCost();
+}
+
+void RegAllocHintStats::recordAssignment(Register reg, unsigned physReg) {
+  unsigned index = Register::virtReg2Index(reg);
+  if (index >= assigned.size())
+    assigned.resize(MRI->getNumVirtRegs());
+  if (assigned.test(index))
+    return;
+  assigned.set(index);
+
+  Register hint = MRI->getSimpleHint(reg);
+  if (!hint)
+    return;
+  hintedVRegs++;
+  if (Register::isVirtualRegister(hint))
+    hint = VRM->hasPhys(hint) ? VRM->getPhys(hint) : Register();
+  satisfiedVRegs += hint == physReg;
+}
+
+RegAllocCopyCost RegAllocHintStats::measureCopies() const {
+  RegAllocCopyCost cost;
+  auto getPhys = [this](Register reg) -> unsigned {
+    if (Register::isPhysicalRegister(reg))
+      return reg;
+    return VRM->hasPhys(reg) ? unsigned(VRM->getPhys(reg)) : 0u;
+  };
+
+  for (const MachineBasicBlock& MBB : *MF) {
+    double freq = MBFI->getBlockFreqRelativeToEntryBlock(&MBB);
+    for (const MachineInstr& MI : MBB) {
+      if (!MI.isFullCopy())
+        continue;
+      Register dst = MI.getOperand(0).getReg();
+      Register src = MI.getOperand(1).getReg();
+      if (!Register::isVirtualRegister(dst) && !Register::isVirtualRegister(src))
+        continue;
+      unsigned dstPhys = getPhys(dst), srcPhys = getPhys(src);
+      if (!dstPhys || !srcPhys)
+        continue;
+      cost.copies++;
+      cost.copyFreq += freq;
+      if (dstPhys != srcPhys) {
+        cost.brokenCopies++;
+        cost.brokenCopyFreq += freq;
+      }
+    }
+  }
+  return cost;
+}
@@ -0,0 +1,23 @@
+#include "llvm/CodeGen/RegAllocInterferenceStats.h"
+
+using namespace llvm;
+
+RegAllocInterferenceStats::PhysRegCounts&
+RegAllocInterferenceStats::PhysRegCounts::operator+=(const PhysRegCounts& other) {
+  checks += other.checks;
+  checkSegments += other.checkSegments;
+  queries += other.queries;
+  querySegments += other.querySegments;
+  cacheHits += other.cacheHits;
+  cacheRevalidations += other.cacheRevalidations;
+  cacheMisses += other.cacheMisses;
+  cacheEvictions += other.cacheEvictions;
+  return *this;
+}
+
+RegAllocInterferenceStats::PhysRegCounts RegAllocInterferenceStats::getTotals() const {
+  PhysRegCounts totals;
+  for (const PhysRegCounts& counts : physRegCounts)
+    totals += counts;
+  return totals;
+}
@@ -0,0 +1,33 @@
+#include "llvm/CodeGen/RegAllocLCRStats.h"
+#include <cassert>
+
+using namespace llvm;
+
+void RegAllocLCRStats::beginInvocation(Register reg, unsigned depthLimit,
+                                       unsigned interferenceLimit) {
+  assert(!inInvocation && "nested outermost recoloring!");
+  inInvocation = true;
+  current = RegAllocLCRInvocation();
+  current.vReg = Register::virtReg2Index(reg);
+  current.depthLimit = depthLimit;
+  current.interferenceLimit = interferenceLimit;
+}
+
+void RegAllocLCRStats::endInvocation(bool succeeded, bool retried, uint64_t nanos) {
+  assert(inInvocation && "no recoloring in progress!");
+  inInvocation = false;
+  current.nanos = nanos;
+  current.flags = (succeeded ? RegAllocLCRInvocation::LCR_Succeeded : 0) |
+                  (retried ? RegAllocLCRInvocation::LCR_Retried : 0);
+  invocations.push_back(current);
+}
+
+void RegAllocLCRStats::recordLimits(uint64_t nanos, unsigned depthLimit,
+                                    unsigned interferenceLimit) {
+  RegAllocLCRLimits limits;
+  limits.invocations = invocations.size();
+  limits.nanos = nanos;
+  limits.depthLimit = depthLimit;
+  limits.interferenceLimit = interferenceLimit;
+  limitChanges.push_back(limits);
+}
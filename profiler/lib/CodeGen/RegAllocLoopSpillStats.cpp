@@ -0,0 +1,25 @@
+#include "llvm/CodeGen/RegAllocLoopSpillStats.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+
+using namespace llvm;
+
+void RegAllocLoopSpillStats::record(const MachineLoop& L, float freq, unsigned reloads,
+                                    unsigned foldedReloads, unsigned spills,
+                                    unsigned foldedSpills) {
+  RegAllocLoopSpills loop;
+  loop.header = L.getHeader()->getNumber();
+  loop.depth = L.getLoopDepth();
+  loop.freq = freq;
+  loop.reloads = reloads;
+  loop.foldedReloads = foldedReloads;
+  loop.spills = spills;
+  loop.foldedSpills = foldedSpills;
+  loop.line = 0;
+  loop.column = 0;
+  if (DebugLoc DL = L.getStartLoc()) {
+    loop.line = DL.getLine();
+    loop.column = DL.getCol();
+    loop.file = DL->getFilename();
+  }
+  loops.push_back(loop);
+}
@@ -0,0 +1,185 @@
+#include "llvm/CodeGen/RegAllocPerfCounters.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace llvm;
+
+const char* getRegAllocPerfPhaseName(RegAllocPerfPhase phase) {
+  switch (phase) {
+  case RPP_AllocatePhysRegs: return "AllocatePhysRegs";
+  case RPP_HintsRecoloring: return "HintsRecoloring";
+  case RPP_PostOptimization: return "PostOptimization";
+  case RPP_NumPhases: break;
+  }
+  llvm_unreachable("invalid regalloc perf phase");
+}
+
+const char* getRegAllocPerfCounterName(RegAllocPerfCounter counter) {
+  switch (counter) {
+  case RPC_Instructions: return "Instructions";
+  case RPC_Cycles: return "Cycles";
+  case RPC_LLCMisses: return "LLCMisses";
+  case RPC_BranchMisses: return "BranchMisses";
+  case RPC_NumCounters: break;
+  }
+  llvm_unreachable("invalid regalloc perf counter");
+}
+
+RegAllocPerfCounters::RegAllocPerfCounters() {
+  for (unsigned c = 0; c < RPC_NumCounters; ++c) {
+    fds[c] = -1;
+    groupIndex[c] = -1;
+    phaseStart[c] = 0;
+  }
+  clear();
+}
+
+void RegAllocPerfCounters::clear() {
+  for (auto& phase : totals)
+    for (auto& total : phase)
+      total = 0;
+}
+
+#if defined(__linux__)
+
+// PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING layout of a group read
+struct GroupReadFormat {
+  uint64_t nr;
+  uint64_t timeEnabled;
+  uint64_t timeRunning;
+  uint64_t values[RPC_NumCounters];
+};
+
+static int openCounter(uint32_t type, uint64_t config, int groupFd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // the leader starts the whole group
+  attr.disabled = groupFd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  // this thread, any CPU
+  return syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+bool RegAllocPerfCounters::open() {
+  close();
+
+  static const struct {
+    uint32_t type;
+    uint64_t config;
+  } Events[RPC_NumCounters] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+  };
+
+  int leader = -1;
+  int firstErrno = 0;
+  for (unsigned c = 0; c < RPC_NumCounters; ++c) {
+    int fd = openCounter(Events[c].type, Events[c].config, leader);
+    if (fd < 0) {
+      if (!firstErrno)
+        firstErrno = errno;
+      continue;
+    }
+    if (leader == -1)
+      leader = fd;
+    fds[c] = fd;
+    groupIndex[c] = groupSize++;
+  }
+
+  if (!groupSize) {
+    // one warning per process is enough, llc may run many modules
+    static bool warned = false;
+    if (!warned)
+      errs() << "warning: regalloc perf counters unavailable: " << std::strerror(firstErrno) << '\n';
+    warned = true;
+    return false;
+  }
+
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+void RegAllocPerfCounters::close() {
+  for (unsigned c = 0; c < RPC_NumCounters; ++c) {
+    if (fds[c] >= 0)
+      ::close(fds[c]);
+    fds[c] = -1;
+    groupIndex[c] = -1;
+  }
+  groupSize = 0;
+}
+
+bool RegAllocPerfCounters::read(uint64_t values[RPC_NumCounters]) const {
+  int leader = -1;
+  for (int fd : fds)
+    if (fd >= 0 && leader == -1)
+      leader = fd;
+
+  GroupReadFormat group;
+  if (::read(leader, &group, sizeof(group)) < (ssize_t)(3 + groupSize) * 8 || group.nr != groupSize)
+    return false;
+
+  // the kernel multiplexes the group with other users of the PMU, extrapolate to the
+  // enabled time like perf stat does
+  for (unsigned c = 0; c < RPC_NumCounters; ++c) {
+    if (groupIndex[c] < 0)
+      continue;
+    uint64_t value = group.values[groupIndex[c]];
+    if (group.timeRunning && group.timeRunning < group.timeEnabled)
+      value = (uint64_t)((double)value * group.timeEnabled / group.timeRunning);
+    values[c] = value;
+  }
+  return true;
+}
+
+#else
+
+bool RegAllocPerfCounters::open() { return false; }
+
+void RegAllocPerfCounters::close() {}
+
+bool RegAllocPerfCounters::read(uint64_t values[RPC_NumCounters]) const { return false; }
+
+#endif
+
+void RegAllocPerfCounters::beginPhase(RegAllocPerfPhase phase) {
+  if (!isOpen())
+    return;
+
+  if (!read(phaseStart))
+    for (auto& value : phaseStart)
+      value = Unavailable;
+}
+
+void RegAllocPerfCounters::endPhase(RegAllocPerfPhase phase) {
+  if (!isOpen())
+    return;
+
+  uint64_t phaseEnd[RPC_NumCounters];
+  if (!read(phaseEnd))
+    return;
+
+  for (unsigned c = 0; c < RPC_NumCounters; ++c)
+    if (groupIndex[c] >= 0 && phaseStart[c] != Unavailable && phaseEnd[c] >= phaseStart[c])
+      totals[phase][c] += phaseEnd[c] - phaseStart[c];
+}
@@ -0,0 +1,37 @@
+#include "llvm/CodeGen/RegAllocPriorityQueue.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace llvm;
+
+void RegAllocBucketedQueue::findTopBucket() {
+  for (unsigned word = NumMaskWords; word-- > 0;)
+    if (nonEmpty[word]) {
+      topBucket = word * 64 + 63 - countLeadingZeros(nonEmpty[word]);
+      return;
+    }
+  topBucket = 0;
+}
+
+void RegAllocBucketedQueue::push(const std::pair<unsigned, unsigned>& entry) {
+  unsigned bucket = bucketOf(entry.first);
+  std::vector<uint64_t>& heap = buckets[bucket];
+  heap.push_back(pack(entry.first, entry.second));
+  std::push_heap(heap.begin(), heap.end());
+
+  nonEmpty[bucket / 64] |= uint64_t(1) << (bucket % 64);
+  if (!numEntries++ || bucket > topBucket)
+    topBucket = bucket;
+}
+
+void RegAllocBucketedQueue::pop() {
+  assert(numEntries && "pop() of an empty queue!");
+  std::vector<uint64_t>& heap = buckets[topBucket];
+  std::pop_heap(heap.begin(), heap.end());
+  heap.pop_back();
+  numEntries--;
+
+  if (heap.empty()) {
+    nonEmpty[topBucket / 64] &= ~(uint64_t(1) << (topBucket % 64));
+    findTopBucket();
+  }
+}
@@ -21,28 +21,95 @@
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/CodeGen/MachineLoopInfo.h"
 #include "llvm/CodeGen/RegAllocProfiler.h"
+#include "InterferenceCache.h"
+#include <algorithm>
 #include <set> 
 #include <cassert> 
-#include <fstream>
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/TimeProfiler.h"
+#include <system_error>
 
 using namespace llvm;
 
+/********************* RegAllocProfilerSink *******************************/
+
+bool RegAllocProfilerSink::open(StringRef fname, size_t threshold) {
+  close();
+  flushThreshold = threshold;
+
+  std::error_code EC;
+  out = std::make_unique<raw_fd_ostream>(fname, EC, sys::fs::OF_Append | sys::fs::OF_Text);
+  if (EC) {
+    errs() << "warning: could not open regalloc profile file '" << fname << "': " << EC.message() << '\n';
+    out.reset();
+    return false;
+  }
+
+  // records are batched in our own buffer, so write them straight through
+  out->SetUnbuffered();
+  return true;
+} 
+
+void RegAllocProfilerSink::flush() {
+  if (!out || buffer.empty())
+    return;
+
+  out->write(buffer.data(), buffer.size());
+  buffer.clear();
+} 
+
+void RegAllocProfilerSink::close() {
+  if (!out)
+    return;
+
+  flush();
+  out->close();
+  out.reset();
+} 
+
+const char* getRegAllocEventKindName(RegAllocEventKind kind) {
+  switch (kind) {
+  case RAE_Assign: return "Assign";
+  case RAE_Evict: return "Evict";
+  case RAE_Evicted: return "Evicted";
+  case RAE_RegionSplit: return "RegionSplit";
+  case RAE_BlockSplit: return "BlockSplit";
+  case RAE_LocalSplit: return "LocalSplit";
+  case RAE_InstructionSplit: return "InstructionSplit";
+  case RAE_Spill: return "Spill";
+  case RAE_LastChanceRecoloring: return "LastChanceRecoloring";
+  case RAE_HintRecoloring: return "HintRecoloring";
+  case RAE_NumKinds: break;
+  } 
+  llvm_unreachable("unknown regalloc event kind");
+} 
+
+/********************* RegAllocProfiler *******************************/
+
 // TODO: get rid of originalVRegSet constructor and compute original VRegSet manual
 RegAllocProfiler::RegAllocProfiler (MachineFunction* MF, 
                                     const TargetRegisterInfo* TRI,
                                     VirtRegMap* VRM,
                                     MachineRegisterInfo* MRI,
-                                    std::set<Register>* splitMarkedVRegs)
+                                    LiveIntervals* LIS,
+                                    const VRegBitSet& splitMarkedVRegs)
                                     :MF(MF), 
                                     TRI(TRI), 
                                     VRM(VRM), 
                                     MRI(MRI),
+                                    LIS(LIS),
                                     VRegInfo(MRI->getVirtRegInfo()),
                                     regMap(VRM->getVirtRegMap()), 
                                     splitMarkedVRegs(splitMarkedVRegs)
                                     {
                                       nominalVirtRegs = MRI->getNumVirtRegs(); 
                                       numUsedVirtRegs = allocatedVirtRegs = numSpilledVirtRegs = 0;
+                                      numClassBuckets = TRI->getNumRegClasses() + 1;
+                                      classNumVRegs.assign(numClassBuckets, 0);
+                                      classAllocBegin.assign(numClassBuckets + 1, 0);
+                                      classUniquePhysRegs.assign(numClassBuckets, 0);
                                     }
 
 bool RegAllocProfiler::isUsedInFunction(Register reg) {
@@ -106,7 +173,22 @@ void RegAllocProfiler::dumpVirtRegInstructions(Register reg) {
 } 
 
 bool RegAllocProfiler::getRegAllocation(Register reg) {
-  return origVRegInfo[reg];
+  unsigned idx = Register::virtReg2Index(reg);
+  return idx < origVRegInfo.size() && origVRegInfo.test(idx);
+} 
+
+// Register class ID of the virtReg, or the trailing bucket if it only has a register bank
+unsigned RegAllocProfiler::getRegClassID(Register reg) {
+  auto vRegInfoPointer = VRegInfo[reg].first; 
+  if (const auto* regClass = vRegInfoPointer.dyn_cast<const TargetRegisterClass*>())
+    return regClass->getID();
+  return numClassBuckets - 1;
+} 
+
+StringRef RegAllocProfiler::getRegClassBucketName(unsigned classID) {
+  if (classID == numClassBuckets - 1)
+    return "";
+  return TRI->getRegClassName(TRI->getRegClass(classID));
 } 
 
 std::string RegAllocProfiler::getRegClassName(Register reg) {
@@ -131,26 +213,52 @@ std::string RegAllocProfiler::getRegClassName(Register reg) {
 // Goes through the DS holding all the virtReg mappings and dumps everything
 void RegAllocProfiler::dump() {
 
-  for (auto const& pair : regClassMap) {
-    errs() << "***********  Register Class: " << pair.first << " *********" <<'\n';
+  for (unsigned classID = 0; classID < numClassBuckets; ++classID) {
+    unsigned begin = classAllocBegin[classID], end = classAllocBegin[classID + 1];
+    if (begin == end)
+      continue;
+
+    errs() << "***********  Register Class: " << getRegClassBucketName(classID) << " *********" <<'\n';
     errs() << '\n';
 
-    // dump all reg names and mapped virtregs
-    for (auto const& mappings: pair.second.nmap) {
-      errs() << mappings.first << ": " << '\n'; 
+    // group the class slice by physReg - stable so vRegs keep ascending order per physReg
+    SmallVector<Register, 32> vRegs(classAllocVRegs.begin() + begin, classAllocVRegs.begin() + end);
+    std::stable_sort(vRegs.begin(), vRegs.end(), [&](Register a, Register b) {
+      return regMap[a] < regMap[b];
+    });
 
-      // convert vReg back to index for easy reading
-      for (auto vReg : mappings.second){
-        errs() << "     ";
-        errs() << Register::virtReg2Index(vReg) << '\n';
+    // dump all reg names and mapped virtregs
+    Register prevPhysReg = 0;
+    for (auto vReg : vRegs) {
+      if (regMap[vReg] != prevPhysReg) {
+        prevPhysReg = regMap[vReg];
+        errs() << getPhysRegName(vReg) << ": " << '\n'; 
       }
 
+      // convert vReg back to index for easy reading
+      errs() << "     ";
+      errs() << Register::virtReg2Index(vReg) << '\n';
     }
     errs() << '\n';
     errs() << "*******************************************" << '\n';
   } 
 }
 
+// One line of the interference breakdown, skipped if nothing was counted
+static void printInterferenceCounts(raw_ostream& os, StringRef name,
+                                    const RegAllocInterferenceStats::PhysRegCounts& counts) {
+  if (counts.empty())
+    return;
+
+  os << name << ": checkInterference " << counts.checks
+     << " (" << counts.checkSegments << " segments visited)"
+     << ", query " << counts.queries << " (" << counts.querySegments << " segments visited)"
+     << ", cache hits " << counts.cacheHits
+     << ", revalidations " << counts.cacheRevalidations
+     << ", misses " << counts.cacheMisses
+     << ", evictions " << counts.cacheEvictions << '\n';
+}
+
 // Prints all the calculated profiler stats
 void RegAllocProfiler::dumpProfilerStats() {
 
@@ -166,10 +274,24 @@ void RegAllocProfiler::dumpProfilerStats() {
   errs() << '\n';
 
   errs() << "Breakdown per register class:" << '\n';
-  for (auto const& pair : regClassData) {
-    errs() << "Register class: " << pair.first << '\n';
-    errs() << "Number of unique registers allocated to this class: " << pair.second.first << '\n';
-    errs() << "Total number of virtRegs allocated to this class: " << pair.second.second << '\n';
+  for (unsigned classID = 0; classID < numClassBuckets; ++classID) {
+    unsigned numAllocated = classAllocBegin[classID + 1] - classAllocBegin[classID];
+    if (!numAllocated)
+      continue;
+    errs() << "Register class: " << getRegClassBucketName(classID) << '\n';
+    errs() << "Number of unique registers allocated to this class: " << classUniquePhysRegs[classID] << '\n';
+    errs() << "Total number of virtRegs allocated to this class: " << numAllocated << '\n';
+    errs() << '\n';
+  }
+
+  if (interferenceStats) {
+    errs() << "Interference checks per physical register:" << '\n';
+    for (unsigned physReg = 1, e = interferenceStats->getNumPhysRegs(); physReg < e; ++physReg) {
+      const RegAllocInterferenceStats::PhysRegCounts& counts = interferenceStats->get(physReg);
+      if (!counts.empty())
+        printInterferenceCounts(errs(), TRI->getName(physReg), counts);
+    }
+    printInterferenceCounts(errs(), "total", interferenceStats->getTotals());
     errs() << '\n';
   }
 
@@ -177,26 +299,691 @@ void RegAllocProfiler::dumpProfilerStats() {
   errs() << "*************************************************************************" << '\n';
 }
 
-void RegAllocProfiler::dumpProfStatsToFile(std::string fname) {
-  std::ofstream f; 
-  f.open(fname,std::fstream::app); 
-  f << '\n';
-  f << "FunctionName " <<(std::string)MF->getName() << '\n';
-  f << "numVirtRegs " << numUsedVirtRegs << '\n'; 
-  f << "allocatedVirtRegs " << allocatedVirtRegs << '\n';
-  f << "spilledVirtRegs " << numSpilledVirtRegs << '\n';
-  f << "endfunctionstats" << '\n';
-  f << '\n';
-  f.close();
- 
+void RegAllocProfiler::writeProfStats(raw_ostream& os) {
+  os << '\n';
+  os << "FunctionName " << MF->getName() << '\n';
+  os << "numVirtRegs " << numUsedVirtRegs << '\n'; 
+  os << "allocatedVirtRegs " << allocatedVirtRegs << '\n';
+  os << "spilledVirtRegs " << numSpilledVirtRegs << '\n';
+  if (events) {
+    os << "regallocEvents " << events->numRecorded() << '\n';
+    os << "droppedEvents " << events->numDropped() << '\n';
+    for (unsigned kind = 0; kind < RAE_NumKinds; ++kind)
+      if (uint64_t count = events->count((RegAllocEventKind)kind))
+        os << "events" << getRegAllocEventKindName((RegAllocEventKind)kind) << ' ' << count << '\n';
+  } 
+  if (evictions) {
+    SmallVector<const RegAllocEviction*, 16> chain;
+    evictions->getLongestChain(chain);
+    os << "evictions " << evictions->numRequeues() << '\n';
+    os << "evictedVirtRegs " << evictions->numEvictedVRegs() << '\n';
+    os << "maxEvictionsPerVirtReg " << evictions->maxEvictionsPerVReg() << '\n';
+    os << "longestEvictionChain " << chain.size() << '\n';
+    if (!chain.empty()) {
+      // vRegs along the chain, each one evicted by the one before it
+      os << "longestEvictionChainVirtRegs " << chain.front()->evictor;
+      for (const RegAllocEviction* E : chain)
+        os << ',' << E->evictee;
+      os << '\n';
+    } 
+  } 
+  if (queueStats) {
+    os << "queueEnqueues " << queueStats->getNumEnqueues() << '\n';
+    os << "queueDequeues " << queueStats->getNumDequeues() << '\n';
+    os << "queueMaxDepth " << queueStats->getMaxDepth() << '\n';
+    os << "queueMeanDepth " << format("%.2f", queueStats->getMeanDepth()) << '\n';
+    os << "droppedUnusedVirtRegs " << queueStats->getNumDroppedUnused() << '\n';
+    for (unsigned stage = 0; stage < RegAllocQueueStats::NumStages; ++stage)
+      if (uint64_t count = queueStats->getStageDequeues(stage))
+        os << "dequeues" << getRegAllocStageName(stage) << ' ' << count << '\n';
+    for (unsigned from = 0; from < RegAllocQueueStats::NumStages; ++from)
+      for (unsigned to = 0; to < RegAllocQueueStats::NumStages; ++to)
+        if (uint64_t count = queueStats->getTransitions(from, to))
+          os << "stage" << getRegAllocStageName(from) << "To" << getRegAllocStageName(to) << ' '
+             << count << '\n';
+
+    // bucket i >= 1 counts original vRegs dequeued [2^(i-1), 2^i) times
+    std::vector<uint32_t> histogram;
+    queueStats->getOrigDequeueHistogram(originalVRegSet, histogram);
+    os << "origVirtRegDequeueHistogram";
+    for (unsigned bucket = 0; bucket < histogram.size(); ++bucket)
+      os << ' ' << (bucket ? 1u << (bucket - 1) : 0) << ':' << histogram[bucket];
+    os << '\n';
+  } 
+  if (interferenceStats) {
+    RegAllocInterferenceStats::PhysRegCounts totals = interferenceStats->getTotals();
+    os << "checkInterferenceCalls " << totals.checks << '\n';
+    os << "queryCalls " << totals.queries << '\n';
+    os << "checkInterferenceSegments " << totals.checkSegments << '\n';
+    os << "querySegments " << totals.querySegments << '\n';
+    os << "intfCacheHits " << totals.cacheHits << '\n';
+    os << "intfCacheRevalidations " << totals.cacheRevalidations << '\n';
+    os << "intfCacheMisses " << totals.cacheMisses << '\n';
+    os << "intfCacheEvictions " << totals.cacheEvictions << '\n';
+  } 
+  if (regionSplitStats) {
+    const RegAllocRegionSplit& totals = regionSplitStats->getTotals();
+    unsigned numFound = 0;
+    for (const RegAllocRegionSplit& split : regionSplitStats->getSplits())
+      numFound += (split.flags & RegAllocRegionSplit::RSF_FoundCandidate) != 0;
+    os << "regionSplitAttempts " << regionSplitStats->getSplits().size() << '\n';
+    os << "regionSplitsWithCandidate " << numFound << '\n';
+    os << "regionSplitCandidates " << totals.candidates << '\n';
+    os << "growRegionIterations " << totals.growIterations << '\n';
+    os << "bundlesActivated " << totals.bundlesActivated << '\n';
+    os << "spillPlacementNanos " << totals.solveNanos << '\n';
+  } 
+  if (lcrStats) {
+    uint64_t numSucceeded = 0, numCandidates = 0, numDepthCutoffs = 0;
+    uint64_t numInterfCutoffs = 0, numRetried = 0, nanos = 0;
+    unsigned maxDepth = 0;
+    for (const RegAllocLCRInvocation& lcr : lcrStats->getInvocations()) {
+      numSucceeded += (lcr.flags & RegAllocLCRInvocation::LCR_Succeeded) != 0;
+      numRetried += (lcr.flags & RegAllocLCRInvocation::LCR_Retried) != 0;
+      numCandidates += lcr.candidates;
+      numDepthCutoffs += lcr.depthCutoffs;
+      numInterfCutoffs += lcr.interferenceCutoffs;
+      nanos += lcr.nanos;
+      maxDepth = std::max(maxDepth, (unsigned)lcr.maxDepth);
+    } 
+    os << "lcrInvocations " << lcrStats->getInvocations().size() << '\n';
+    os << "lcrSucceeded " << numSucceeded << '\n';
+    os << "lcrCandidates " << numCandidates << '\n';
+    os << "lcrMaxDepth " << maxDepth << '\n';
+    os << "lcrDepthCutoffs " << numDepthCutoffs << '\n';
+    os << "lcrInterferenceCutoffs " << numInterfCutoffs << '\n';
+    os << "lcrRetries " << numRetried << '\n';
+    os << "lcrNanos " << nanos << '\n';
+    // invocations nanos depthLimit interferenceLimit
+    for (const RegAllocLCRLimits& limits : lcrStats->getLimitChanges())
+      os << "lcrAdaptiveLimits " << limits.invocations << ' ' << limits.nanos << ' '
+         << limits.depthLimit << ' ' << limits.interferenceLimit << '\n';
+  } 
+  if (spillCost) {
+    // spill code instructions, and the same weighted by block frequency relative to entry
+    const RegAllocSpillCost& totals = spillCost->getTotals();
+    for (unsigned kind = 0; kind < RSK_NumKinds; ++kind) {
+      const char* name = getRegAllocSpillKindName((RegAllocSpillKind)kind);
+      os << "spillCode" << name << ' ' << totals.counts[kind] << '\n';
+      os << "spillCost" << name << ' ' << format("%.2f", totals.weights[kind]) << '\n';
+    } 
+    os << "spillCost " << format("%.2f", totals.getTotalWeight()) << '\n';
+    unsigned numCharged = 0;
+    for (Register reg : spillCost->getOriginalVRegs())
+      numCharged += !spillCost->get(reg).empty();
+    os << "spillCostVirtRegs " << numCharged << '\n';
+    if (spillCost->hasCycles()) {
+      // estimated cycles the spill code adds, by latency and by reciprocal throughput
+      const RegAllocSpillCycles& cycles = spillCost->getCycles();
+      for (unsigned kind = 0; kind < RSK_NumKinds; ++kind) {
+        const char* name = getRegAllocSpillKindName((RegAllocSpillKind)kind);
+        os << "spillLatencyCycles" << name << ' ' << format("%.2f", cycles.latency[kind]) << '\n';
+        os << "spillThroughputCycles" << name << ' '
+           << format("%.2f", cycles.reciprocalThroughput[kind]) << '\n';
+      } 
+      os << "spillLatencyCycles " << format("%.2f", cycles.getTotalLatency()) << '\n';
+      os << "spillThroughputCycles " << format("%.2f", cycles.getTotalReciprocalThroughput())
+         << '\n';
+    } 
+  } 
+  if (splitTree) {
+    // split originals, the mean fraction of their live range that stayed in registers,
+    // and how many of them stayed mostly in registers - origVRegInfo counts them as spilled
+    unsigned numSplit = 0, numMostlyInRegs = 0;
+    double fractionSum = 0;
+    unsigned kindCounts[RSP_NumKinds] = {};
+    for (const RegAllocSplitNode& node : splitTree->getNodes()) {
+      kindCounts[node.kind]++;
+      if (node.kind != RSP_Original || !node.hasChildren)
+        continue;
+      float fraction = splitTree->getRegFraction(Register::index2VirtReg(node.vReg));
+      numSplit++;
+      fractionSum += fraction;
+      numMostlyInRegs += fraction >= 0.5f;
+    } 
+    os << "splitOrigVirtRegs " << numSplit << '\n';
+    os << "splitOrigVirtRegsMostlyInRegs " << numMostlyInRegs << '\n';
+    os << "splitMeanRegFraction " << format("%.3f", numSplit ? fractionSum / numSplit : 0.0)
+       << '\n';
+    for (unsigned kind = RSP_Original + 1; kind < RSP_NumKinds; ++kind)
+      os << "splitTreeNodes" << getRegAllocSplitKindName((RegAllocSplitKind)kind) << ' '
+         << kindCounts[kind] << '\n';
+  } 
+  if (hintStats) {
+    const RegAllocCopyCost& before = hintStats->getCopiesBeforeRecoloring();
+    const RegAllocCopyCost& after = hintStats->getCopiesAfterRecoloring();
+    os << "hintedVirtRegs " << hintStats->getHintedVRegs() << '\n';
+    os << "hintsSatisfiedFirstAssignment " << hintStats->getSatisfiedVRegs() << '\n';
+    os << "hintRecoloringCandidates " << hintStats->getRecoloringCandidates() << '\n';
+    os << "hintRecoloredVirtRegs " << hintStats->getRecoloredVRegs() << '\n';
+    os << "copies " << after.copies << '\n';
+    // broken hints repaired by tryHintsRecoloring, negative if it broke more than it fixed
+    os << "hintsRecoveredByRecoloring " << (int64_t)before.brokenCopies - after.brokenCopies
+       << '\n';
+    os << "brokenHintCopies " << after.brokenCopies << '\n';
+    os << "brokenHintCopyFreqBeforeRecoloring " << format("%.2f", before.brokenCopyFreq) << '\n';
+    os << "brokenHintCopyFreq " << format("%.2f", after.brokenCopyFreq) << '\n';
+  } 
+  if (csrStats) {
+    unsigned outcomes[3] = {};
+    for (const RegAllocCSRDecision& decision : csrStats->getDecisions())
+      outcomes[decision.outcome]++;
+    os << "csrFirstUseCost " << csrStats->getCSRCost() << '\n';
+    os << "csrDecisions " << csrStats->getDecisions().size() << '\n';
+    os << "csrDecisionsUse " << outcomes[RegAllocCSRDecision::CSR_Use] << '\n';
+    os << "csrDecisionsSpill " << outcomes[RegAllocCSRDecision::CSR_Spill] << '\n';
+    os << "csrDecisionsSplit " << outcomes[RegAllocCSRDecision::CSR_Split] << '\n';
+    os << "calleeSavedRegs " << csrStats->getNumCSRs() << '\n';
+    os << "calleeSavedRegsUsed " << csrStats->getNumUsedCSRs() << '\n';
+  } 
+  if (loopSpills) {
+    os << "loopsWithSpillCode " << loopSpills->getLoops().size() << '\n';
+    // header depth freq reloads foldedReloads spills foldedSpills file:line:column
+    for (const RegAllocLoopSpills& loop : loopSpills->getLoops())
+      os << "loopSpills " << loop.header << ' ' << loop.depth << ' ' << format("%.2f", loop.freq)
+         << ' ' << loop.reloads << ' ' << loop.foldedReloads << ' ' << loop.spills << ' '
+         << loop.foldedSpills << ' ' << loop.file << ':' << loop.line << ':' << loop.column
+         << '\n';
+  } 
+  if (perfCounters) {
+    for (unsigned phase = 0; phase < RPP_NumPhases; ++phase)
+      for (unsigned counter = 0; counter < RPC_NumCounters; ++counter) {
+        uint64_t value = perfCounters->get((RegAllocPerfPhase)phase, (RegAllocPerfCounter)counter);
+        if (value != RegAllocPerfCounters::Unavailable)
+          os << "perf" << getRegAllocPerfPhaseName((RegAllocPerfPhase)phase)
+             << getRegAllocPerfCounterName((RegAllocPerfCounter)counter) << ' ' << value << '\n';
+      } 
+  } 
+  os << "endfunctionstats" << '\n';
+  os << '\n';
+} 
+
+void RegAllocProfiler::dumpProfStatsToSink(RegAllocProfilerSink& sink) {
+  if (!sink.isOpen())
+    return;
+
+  writeProfStats(sink.record());
+  sink.endRecord();
+} 
+
+// Trace table layouts
+static const RegAllocTrace::ColumnDesc FunctionColumns[] = {
+  {"name", RegAllocTrace::CT_Str},
+  {"nominal_vregs", RegAllocTrace::CT_U32},
+  {"used_vregs", RegAllocTrace::CT_U32},
+  {"allocated_vregs", RegAllocTrace::CT_U32},
+  {"spilled_vregs", RegAllocTrace::CT_U32},
+  {"events", RegAllocTrace::CT_U64},
+  {"dropped_events", RegAllocTrace::CT_U64},
+  // block frequency weighted spill code, 0 if it was not measured
+  {"spill_cost", RegAllocTrace::CT_F32}
+};
+
+static const RegAllocTrace::ColumnDesc VRegColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"index", RegAllocTrace::CT_U32},
+  {"class_id", RegAllocTrace::CT_U16},
+  {"flags", RegAllocTrace::CT_U8},
+  {"location", RegAllocTrace::CT_U32},
+  {"size", RegAllocTrace::CT_U32},
+  {"weight", RegAllocTrace::CT_F32},
+  // times the vReg or one of its split products was dequeued
+  {"dequeues", RegAllocTrace::CT_U32},
+  // fraction of the live range that stayed in registers - see RegAllocSplitTree
+  {"reg_fraction", RegAllocTrace::CT_F32}
+};
+
+static const RegAllocTrace::ColumnDesc EventColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"kind", RegAllocTrace::CT_U8},
+  {"stage", RegAllocTrace::CT_U8},
+  {"vreg", RegAllocTrace::CT_U32},
+  {"physreg", RegAllocTrace::CT_U16},
+  {"start", RegAllocTrace::CT_U32},
+  {"end", RegAllocTrace::CT_U32}
+};
+
+// one row per eviction, in allocation order
+static const RegAllocTrace::ColumnDesc EvictionColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"evictor", RegAllocTrace::CT_U32},
+  {"evictee", RegAllocTrace::CT_U32},
+  {"physreg", RegAllocTrace::CT_U16},
+  {"cascade", RegAllocTrace::CT_U32},
+  {"broken_hints", RegAllocTrace::CT_U32},
+  {"max_weight", RegAllocTrace::CT_F32}
+};
+
+// queue size before every dequeue, in dequeue order
+static const RegAllocTrace::ColumnDesc QueueDepthColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"depth", RegAllocTrace::CT_U32}
+};
+
+// non-zero entries of the LiveRangeStage transition matrix
+static const RegAllocTrace::ColumnDesc StageTransitionColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"from", RegAllocTrace::CT_U8},
+  {"to", RegAllocTrace::CT_U8},
+  {"count", RegAllocTrace::CT_U64}
+};
+
+// one row per physReg with any interference activity
+static const RegAllocTrace::ColumnDesc InterferenceColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"physreg", RegAllocTrace::CT_U16},
+  {"checks", RegAllocTrace::CT_U64},
+  {"check_segments", RegAllocTrace::CT_U64},
+  {"queries", RegAllocTrace::CT_U64},
+  {"query_segments", RegAllocTrace::CT_U64},
+  {"cache_hits", RegAllocTrace::CT_U64},
+  {"cache_revalidations", RegAllocTrace::CT_U64},
+  {"cache_misses", RegAllocTrace::CT_U64},
+  {"cache_evictions", RegAllocTrace::CT_U64}
+};
+
+// one row per tryRegionSplit attempt - see RegAllocRegionSplit
+static const RegAllocTrace::ColumnDesc RegionSplitColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"vreg", RegAllocTrace::CT_U32},
+  {"size", RegAllocTrace::CT_U32},
+  {"through_blocks", RegAllocTrace::CT_U32},
+  {"candidates", RegAllocTrace::CT_U32},
+  {"grow_iterations", RegAllocTrace::CT_U32},
+  {"bundles_activated", RegAllocTrace::CT_U32},
+  {"solve_ns", RegAllocTrace::CT_U64},
+  {"spill_cost", RegAllocTrace::CT_U64},
+  {"best_cost", RegAllocTrace::CT_U64},
+  {"flags", RegAllocTrace::CT_U8}
+};
+
+// one row per outermost tryLastChanceRecoloring call - see RegAllocLCRInvocation
+static const RegAllocTrace::ColumnDesc LCRColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"vreg", RegAllocTrace::CT_U32},
+  {"depth_limit", RegAllocTrace::CT_U32},
+  {"interference_limit", RegAllocTrace::CT_U32},
+  {"max_depth", RegAllocTrace::CT_U32},
+  {"candidates", RegAllocTrace::CT_U32},
+  {"depth_cutoffs", RegAllocTrace::CT_U32},
+  {"interference_cutoffs", RegAllocTrace::CT_U32},
+  {"ns", RegAllocTrace::CT_U64},
+  {"flags", RegAllocTrace::CT_U8}
+};
+
+// one row per adaptive lowering of the recoloring limits
+static const RegAllocTrace::ColumnDesc LCRLimitColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"invocations", RegAllocTrace::CT_U32},
+  {"ns", RegAllocTrace::CT_U64},
+  {"depth_limit", RegAllocTrace::CT_U32},
+  {"interference_limit", RegAllocTrace::CT_U32}
+};
+
+// one row per original vReg charged with spill code - counts, then the same weighted by
+// block frequency relative to the entry block
+static const RegAllocTrace::ColumnDesc SpillCostColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"vreg", RegAllocTrace::CT_U32},
+  {"spills", RegAllocTrace::CT_U32},
+  {"reloads", RegAllocTrace::CT_U32},
+  {"folded_spills", RegAllocTrace::CT_U32},
+  {"folded_reloads", RegAllocTrace::CT_U32},
+  {"remats", RegAllocTrace::CT_U32},
+  {"spill_weight", RegAllocTrace::CT_F32},
+  {"reload_weight", RegAllocTrace::CT_F32},
+  {"folded_spill_weight", RegAllocTrace::CT_F32},
+  {"folded_reload_weight", RegAllocTrace::CT_F32},
+  {"remat_weight", RegAllocTrace::CT_F32}
+};
+
+// one row per spill code kind, only with -regalloc-profile-sched-cost - see RegAllocSpillCycles
+static const RegAllocTrace::ColumnDesc SpillCycleColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"kind", RegAllocTrace::CT_U8},
+  {"instructions", RegAllocTrace::CT_U32},
+  {"weight", RegAllocTrace::CT_F32},
+  {"latency_cycles", RegAllocTrace::CT_F32},
+  {"throughput_cycles", RegAllocTrace::CT_F32}
+};
+
+// one row per vReg split off an original vReg (or created spilling one) - see RegAllocSplitNode
+static const RegAllocTrace::ColumnDesc SplitTreeColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"vreg", RegAllocTrace::CT_U32},
+  {"parent", RegAllocTrace::CT_U32},
+  {"original", RegAllocTrace::CT_U32},
+  {"kind", RegAllocTrace::CT_U8},
+  {"size", RegAllocTrace::CT_U32},
+  {"location", RegAllocTrace::CT_U8}
+};
+
+// one row per function - see RegAllocHintStats, copy frequencies are relative to the entry block
+static const RegAllocTrace::ColumnDesc HintColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"hinted_vregs", RegAllocTrace::CT_U32},
+  {"satisfied_first", RegAllocTrace::CT_U32},
+  {"recoloring_candidates", RegAllocTrace::CT_U32},
+  {"recolored_vregs", RegAllocTrace::CT_U32},
+  {"copies", RegAllocTrace::CT_U32},
+  {"broken_before", RegAllocTrace::CT_U32},
+  {"broken_after", RegAllocTrace::CT_U32},
+  {"broken_freq_before", RegAllocTrace::CT_F32},
+  {"broken_freq_after", RegAllocTrace::CT_F32}
+};
+
+// one row per RAGreedy::tryAssignCSRFirstTime call - see RegAllocCSRDecision, alt_cost is
+// RegAllocCSRDecision::NoAltCost (all ones) when no alternative was priced
+static const RegAllocTrace::ColumnDesc CSRDecisionColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"vreg", RegAllocTrace::CT_U32},
+  {"physreg", RegAllocTrace::CT_U16},
+  {"stage", RegAllocTrace::CT_U8},
+  {"alternative", RegAllocTrace::CT_U8},
+  {"outcome", RegAllocTrace::CT_U8},
+  {"csr_cost", RegAllocTrace::CT_U64},
+  {"alt_cost", RegAllocTrace::CT_U64}
+};
+
+// one row per function
+static const RegAllocTrace::ColumnDesc CSRUsageColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"csr_cost", RegAllocTrace::CT_U64},
+  {"csrs", RegAllocTrace::CT_U32},
+  {"used_csrs", RegAllocTrace::CT_U32}
+};
+
+// one row per loop with spill code - counts include subloops, see RegAllocLoopSpills
+static const RegAllocTrace::ColumnDesc LoopSpillColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"header", RegAllocTrace::CT_U32},
+  {"depth", RegAllocTrace::CT_U32},
+  {"freq", RegAllocTrace::CT_F32},
+  {"reloads", RegAllocTrace::CT_U32},
+  {"folded_reloads", RegAllocTrace::CT_U32},
+  {"spills", RegAllocTrace::CT_U32},
+  {"folded_spills", RegAllocTrace::CT_U32},
+  {"file", RegAllocTrace::CT_Str},
+  {"line", RegAllocTrace::CT_U32},
+  {"column", RegAllocTrace::CT_U32}
+};
+
+// one row per phase, unavailable counters hold RegAllocPerfCounters::Unavailable
+static const RegAllocTrace::ColumnDesc PerfCounterColumns[] = {
+  {"function", RegAllocTrace::CT_U32},
+  {"phase", RegAllocTrace::CT_U8},
+  {"instructions", RegAllocTrace::CT_U64},
+  {"cycles", RegAllocTrace::CT_U64},
+  {"llc_misses", RegAllocTrace::CT_U64},
+  {"branch_misses", RegAllocTrace::CT_U64}
+};
+
+void RegAllocProfiler::dumpProfStatsToTrace(RegAllocTraceWriter& trace) {
+  if (!trace.isOpen())
+    return;
+
+  trace.setTarget(TRI);
+
+  RegAllocTraceTable& functions = trace.table("functions", FunctionColumns);
+  traceFunctionRow = functions.size();
+  functions.addStr(MF->getName())
+           .addU32(nominalVirtRegs)
+           .addU32(numUsedVirtRegs)
+           .addU32(allocatedVirtRegs)
+           .addU32(numSpilledVirtRegs)
+           .addU64(events ? events->numRecorded() : 0)
+           .addU64(events ? events->numDropped() : 0)
+           .addF32(spillCost ? spillCost->getTotals().getTotalWeight() : 0)
+           .endRow();
+
+  RegAllocTraceTable& vRegs = trace.table("vregs", VRegColumns);
+  for (unsigned i = 0, e = originalVRegSet.size(); i != e; ++i) {
+    Register reg = originalVRegSet[i];
+    uint8_t flags = 0;
+    uint32_t location = 0;
+
+    if (splitMarkedVRegs.contains(reg))
+      flags |= RegAllocTrace::VF_SplitMarked;
+
+    if (getRegAllocation(reg)) {
+      flags |= RegAllocTrace::VF_Allocated;
+      location = regMap[reg];
+    } 
+    else if (isSpilled(reg)) {
+      flags |= RegAllocTrace::VF_StackSlot;
+      location = VRM->getStackSlot(reg);
+    } 
+
+    vRegs.addU32(traceFunctionRow)
+         .addU32(Register::virtReg2Index(reg))
+         .addU16(getRegClassID(reg))
+         .addU8(flags)
+         .addU32(location)
+         .addU32(origVRegSize[i])
+         .addF32(origVRegWeight[i])
+         .addU32(queueStats ? queueStats->getOrigDequeues(reg) : 0)
+         .addF32(splitTree ? splitTree->getRegFraction(reg) : 0)
+         .endRow();
+  } 
+
+  if (events) {
+    RegAllocTraceTable& eventTable = trace.table("events", EventColumns);
+    events->forEach([&](const RegAllocEvent& E) {
+      eventTable.addU32(traceFunctionRow)
+                .addU8(E.kind)
+                .addU8(E.stage)
+                .addU32(E.vReg)
+                .addU16(E.physReg)
+                .addU32(E.start)
+                .addU32(E.end)
+                .endRow();
+    });
+  } 
+
+  if (evictions) {
+    RegAllocTraceTable& evictionTable = trace.table("evictions", EvictionColumns);
+    for (const RegAllocEviction& E : evictions->getEdges())
+      evictionTable.addU32(traceFunctionRow)
+                   .addU32(E.evictor)
+                   .addU32(E.evictee)
+                   .addU16(E.physReg)
+                   .addU32(E.cascade)
+                   .addU32(E.brokenHints)
+                   .addF32(E.maxWeight)
+                   .endRow();
+  } 
+
+  if (queueStats) {
+    RegAllocTraceTable& depthTable = trace.table("queuedepth", QueueDepthColumns);
+    for (uint32_t depth : queueStats->getDepthSamples())
+      depthTable.addU32(traceFunctionRow).addU32(depth).endRow();
+
+    RegAllocTraceTable& transitionTable = trace.table("stagetransitions", StageTransitionColumns);
+    for (unsigned from = 0; from < RegAllocQueueStats::NumStages; ++from)
+      for (unsigned to = 0; to < RegAllocQueueStats::NumStages; ++to)
+        if (uint64_t count = queueStats->getTransitions(from, to))
+          transitionTable.addU32(traceFunctionRow).addU8(from).addU8(to).addU64(count).endRow();
+  } 
+
+  if (interferenceStats) {
+    RegAllocTraceTable& intfTable = trace.table("interference", InterferenceColumns);
+    for (unsigned physReg = 1, e = interferenceStats->getNumPhysRegs(); physReg < e; ++physReg) {
+      const RegAllocInterferenceStats::PhysRegCounts& counts = interferenceStats->get(physReg);
+      if (counts.empty())
+        continue;
+      intfTable.addU32(traceFunctionRow)
+               .addU16(physReg)
+               .addU64(counts.checks)
+               .addU64(counts.checkSegments)
+               .addU64(counts.queries)
+               .addU64(counts.querySegments)
+               .addU64(counts.cacheHits)
+               .addU64(counts.cacheRevalidations)
+               .addU64(counts.cacheMisses)
+               .addU64(counts.cacheEvictions)
+               .endRow();
+    } 
+  } 
+
+  if (regionSplitStats) {
+    RegAllocTraceTable& splitTable = trace.table("regionsplits", RegionSplitColumns);
+    for (const RegAllocRegionSplit& split : regionSplitStats->getSplits())
+      splitTable.addU32(traceFunctionRow)
+                .addU32(split.vReg)
+                .addU32(split.size)
+                .addU32(split.throughBlocks)
+                .addU32(split.candidates)
+                .addU32(split.growIterations)
+                .addU32(split.bundlesActivated)
+                .addU64(split.solveNanos)
+                .addU64(split.spillCost)
+                .addU64(split.bestCost)
+                .addU8(split.flags)
+                .endRow();
+  } 
+
+  if (lcrStats) {
+    RegAllocTraceTable& lcrTable = trace.table("lastchancerecolorings", LCRColumns);
+    for (const RegAllocLCRInvocation& lcr : lcrStats->getInvocations())
+      lcrTable.addU32(traceFunctionRow)
+              .addU32(lcr.vReg)
+              .addU32(lcr.depthLimit)
+              .addU32(lcr.interferenceLimit)
+              .addU32(lcr.maxDepth)
+              .addU32(lcr.candidates)
+              .addU32(lcr.depthCutoffs)
+              .addU32(lcr.interferenceCutoffs)
+              .addU64(lcr.nanos)
+              .addU8(lcr.flags)
+              .endRow();
+
+    RegAllocTraceTable& limitTable = trace.table("lcrlimits", LCRLimitColumns);
+    for (const RegAllocLCRLimits& limits : lcrStats->getLimitChanges())
+      limitTable.addU32(traceFunctionRow)
+                .addU32(limits.invocations)
+                .addU64(limits.nanos)
+                .addU32(limits.depthLimit)
+                .addU32(limits.interferenceLimit)
+                .endRow();
+  } 
+
+  if (spillCost) {
+    RegAllocTraceTable& costTable = trace.table("spillcost", SpillCostColumns);
+    for (Register reg : spillCost->getOriginalVRegs()) {
+      const RegAllocSpillCost& cost = spillCost->get(reg);
+      if (cost.empty())
+        continue;
+      costTable.addU32(traceFunctionRow).addU32(Register::virtReg2Index(reg));
+      for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+        costTable.addU32(cost.counts[kind]);
+      for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+        costTable.addF32(cost.weights[kind]);
+      costTable.endRow();
+    } 
+
+    if (spillCost->hasCycles()) {
+      RegAllocTraceTable& cycleTable = trace.table("spillcycles", SpillCycleColumns);
+      const RegAllocSpillCost& totals = spillCost->getTotals();
+      const RegAllocSpillCycles& cycles = spillCost->getCycles();
+      for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+        cycleTable.addU32(traceFunctionRow)
+                  .addU8(kind)
+                  .addU32(totals.counts[kind])
+                  .addF32(totals.weights[kind])
+                  .addF32(cycles.latency[kind])
+                  .addF32(cycles.reciprocalThroughput[kind])
+                  .endRow();
+    } 
+  } 
+
+  if (splitTree) {
+    RegAllocTraceTable& treeTable = trace.table("splittree", SplitTreeColumns);
+    for (const RegAllocSplitNode& node : splitTree->getNodes())
+      if (node.kind != RSP_Original)
+        treeTable.addU32(traceFunctionRow)
+                 .addU32(node.vReg)
+                 .addU32(node.parent)
+                 .addU32(node.original)
+                 .addU8(node.kind)
+                 .addU32(node.size)
+                 .addU8(node.location)
+                 .endRow();
+  } 
+
+  if (hintStats) {
+    const RegAllocCopyCost& before = hintStats->getCopiesBeforeRecoloring();
+    const RegAllocCopyCost& after = hintStats->getCopiesAfterRecoloring();
+    trace.table("hints", HintColumns)
+         .addU32(traceFunctionRow)
+         .addU32(hintStats->getHintedVRegs())
+         .addU32(hintStats->getSatisfiedVRegs())
+         .addU32(hintStats->getRecoloringCandidates())
+         .addU32(hintStats->getRecoloredVRegs())
+         .addU32(after.copies)
+         .addU32(before.brokenCopies)
+         .addU32(after.brokenCopies)
+         .addF32(before.brokenCopyFreq)
+         .addF32(after.brokenCopyFreq)
+         .endRow();
+  } 
+
+  if (csrStats) {
+    RegAllocTraceTable& decisionTable = trace.table("csrdecisions", CSRDecisionColumns);
+    for (const RegAllocCSRDecision& decision : csrStats->getDecisions())
+      decisionTable.addU32(traceFunctionRow)
+                   .addU32(decision.vReg)
+                   .addU16(decision.physReg)
+                   .addU8(decision.stage)
+                   .addU8(decision.alternative)
+                   .addU8(decision.outcome)
+                   .addU64(decision.csrCost)
+                   .addU64(decision.altCost)
+                   .endRow();
+
+    trace.table("csrusage", CSRUsageColumns)
+         .addU32(traceFunctionRow)
+         .addU64(csrStats->getCSRCost())
+         .addU32(csrStats->getNumCSRs())
+         .addU32(csrStats->getNumUsedCSRs())
+         .endRow();
+  } 
+
+  if (loopSpills) {
+    RegAllocTraceTable& loopTable = trace.table("loopspills", LoopSpillColumns);
+    for (const RegAllocLoopSpills& loop : loopSpills->getLoops())
+      loopTable.addU32(traceFunctionRow)
+               .addU32(loop.header)
+               .addU32(loop.depth)
+               .addF32(loop.freq)
+               .addU32(loop.reloads)
+               .addU32(loop.foldedReloads)
+               .addU32(loop.spills)
+               .addU32(loop.foldedSpills)
+               .addStr(loop.file)
+               .addU32(loop.line)
+               .addU32(loop.column)
+               .endRow();
+  } 
+
+  if (perfCounters) {
+    RegAllocTraceTable& perfTable = trace.table("perfcounters", PerfCounterColumns);
+    for (unsigned phase = 0; phase < RPP_NumPhases; ++phase) {
+      perfTable.addU32(traceFunctionRow).addU8(phase);
+      for (unsigned counter = 0; counter < RPC_NumCounters; ++counter)
+        perfTable.addU64(perfCounters->get((RegAllocPerfPhase)phase, (RegAllocPerfCounter)counter));
+      perfTable.endRow();
+    } 
+  } 
+
+  trace.endFunction();
 } 
 
 // 10/31 -- Added method to dump all mappings for origVRegSet
 void RegAllocProfiler::dumpOrigVRegMappings() {
   errs() << "***************VREG MAPPINGS********************" << '\n';
 
-  for (auto const& pair : origVRegInfo) {
-    errs() << Register::virtReg2Index(pair.first) << " : " << pair.second << '\n';
+  for (auto reg : originalVRegSet) {
+    errs() << Register::virtReg2Index(reg) << " : " << getRegAllocation(reg) << '\n';
   } 
 } 
 
@@ -224,14 +1011,17 @@ void RegAllocProfiler::writeDebugStats (MachineFunction& MF) {
   errs() << '\n';
 
   errs() << "Variable Data" << '\n';
-  for (auto const& pair : vRegClassData) {
-    errs() << "Num " << pair.first << " Variables: " << pair.second.size();
+  for (unsigned classID = 0; classID < numClassBuckets; ++classID) {
+    if (classNumVRegs[classID])
+      errs() << "Num " << getRegClassBucketName(classID) << " Variables: " << classNumVRegs[classID];
   } 
   errs() << "*********" << '\n';
 
   errs() << "Allocations per class" << '\n';
-  for (auto const& pair : regClassData) {
-    errs() << "Class: " << pair.first << " : " << pair.second.second << '\n';
+  for (unsigned classID = 0; classID < numClassBuckets; ++classID) {
+    unsigned numAllocated = classAllocBegin[classID + 1] - classAllocBegin[classID];
+    if (numAllocated)
+      errs() << "Class: " << getRegClassBucketName(classID) << " : " << numAllocated << '\n';
   }
   errs() << "*********" << '\n';
 
@@ -240,9 +1030,9 @@ void RegAllocProfiler::writeDebugStats (MachineFunction& MF) {
   for (auto reg : originalVRegSet) {
 
     errs() << "REGISTER: " << Register::virtReg2Index(reg) << '\n';
-    errs() << "Allocation status: " << origVRegInfo[reg] << '\n';
+    errs() << "Allocation status: " << getRegAllocation(reg) << '\n';
 
-    if (origVRegInfo[reg])
+    if (getRegAllocation(reg))
       errs() << "Allocated to: " << getPhysRegName(reg) << '\n';
 
     errs() << "Machine Instructions: " << '\n';
@@ -257,8 +1047,12 @@ void RegAllocProfiler::writeDebugStats (MachineFunction& MF) {
 }
 
 
+// The original vReg set itself is recorded while seedLiveRegs() walks the vRegs, so all
+// that is left to do here is to size the containers for it
 void RegAllocProfiler::init() {
-  getOriginalVRegs();
+  originalVRegSet.reserve(nominalVirtRegs);
+  origVRegSize.reserve(nominalVirtRegs);
+  origVRegWeight.reserve(nominalVirtRegs);
 } 
 
 void RegAllocProfiler::computeStats() {
@@ -266,56 +1060,170 @@ void RegAllocProfiler::computeStats() {
   calculateProfilerStats();
 } 
 
+/********************* RegAllocProfilerHooks *******************************/
+
+void RegAllocProfilerHooks<true>::beginModule(bool enable, StringRef profileFile,
+                                              StringRef traceFile, size_t bufferSize,
+                                              bool countPerfEvents) {
+  enabled = enable;
+  if (!enabled)
+    return;
+
+  sink.open(profileFile, bufferSize);
+  if (!traceFile.empty())
+    trace.open(traceFile, bufferSize);
+  if (countPerfEvents)
+    perfCounters.open();
+} 
+
+void RegAllocProfilerHooks<true>::endModule() {
+  sink.close();
+  trace.close();
+  perfCounters.close();
+} 
+
+void RegAllocProfilerHooks<true>::beginFunction(MachineFunction* MF,
+                                                const TargetRegisterInfo* TRI,
+                                                VirtRegMap* VRM,
+                                                MachineRegisterInfo* MRI,
+                                                LiveIntervals* LIS) {
+  if (!enabled)
+    return;
+
+  splitMarkedVRegs.reserve(MRI->getNumVirtRegs());
+  splitMarkedVRegs.clear();
+  events.clear(LIS->getSlotIndexes()->getZeroIndex());
+  profiler = std::make_unique<RegAllocProfiler>(MF, TRI, VRM, MRI, LIS, splitMarkedVRegs);
+  profiler->attachEvents(events);
+  evictions.clear();
+  profiler->attachEvictions(evictions);
+  queueStats.clear(MRI->getNumVirtRegs());
+  profiler->attachQueueStats(queueStats);
+  regionSplitStats.clear();
+  profiler->attachRegionSplitStats(regionSplitStats);
+  lcrStats.clear();
+  profiler->attachLCRStats(lcrStats);
+  loopSpills.clear();
+  profiler->attachLoopSpills(loopSpills);
+  splitTree.clear(VRM, MRI, LIS);
+  profiler->attachSplitTree(splitTree);
+  if (perfCounters.isOpen()) {
+    perfCounters.clear();
+    profiler->attachPerfCounters(perfCounters);
+  } 
+  profiler->init();
+} 
+
+void RegAllocProfilerHooks<true>::trackInterference(const TargetRegisterInfo* TRI,
+                                                    InterferenceCache& cache) {
+  if (!profiler)
+    return;
+
+  interferenceStats.clear(TRI);
+  cache.setStats(&interferenceStats);
+  profiler->attachInterferenceStats(interferenceStats);
+} 
+
+void RegAllocProfilerHooks<true>::trackSpillCost(const MachineFunction* MF, const VirtRegMap* VRM,
+                                                 const MachineRegisterInfo* MRI,
+                                                 const MachineBlockFrequencyInfo* MBFI,
+                                                 bool priceCycles) {
+  if (!profiler)
+    return;
+
+  spillCost.clear(MF, VRM, MRI, MBFI, priceCycles);
+  profiler->attachSpillCost(spillCost);
+} 
+
+void RegAllocProfilerHooks<true>::trackHints(const MachineFunction* MF, const VirtRegMap* VRM,
+                                             const MachineRegisterInfo* MRI,
+                                             const MachineBlockFrequencyInfo* MBFI) {
+  if (!profiler)
+    return;
+
+  hintStats.clear(MF, VRM, MRI, MBFI);
+  profiler->attachHintStats(hintStats);
+} 
+
+void RegAllocProfilerHooks<true>::trackCSRCost(uint64_t csrCost) {
+  if (!profiler)
+    return;
+
+  csrStats.clear(csrCost);
+  profiler->attachCSRStats(csrStats);
+} 
+
+void RegAllocProfilerHooks<true>::endFunction() {
+  if (!profiler)
+    return;
+
+  {
+    TimeTraceScope timeScope("RegAllocProfilerStats", profiler->getFunctionName());
+    if (spillCost.isTracking())
+      spillCost.compute();
+    splitTree.compute();
+    profiler->computeStats();
+  }
+
+  // HKHAJ - 11/10 
+  // Comparing split-marked vregs against the allocation status of the vReg - they should match or else
+  // bug 
+  /*
+  for (auto reg : profiler->originalVRegs()) {
+    if (!splitMarkedVRegs.contains(reg))
+      continue;
+
+    errs() << "Checking vreg: " << Register::virtReg2Index(reg) << '\n';
+    assert (!profiler->getRegAllocation(reg) && "found a vreg that was split-marked but marked as allocated!");
+  } 
+  */
+
+  //profiler->dumpProfilerStats();
+  // 10/31 - added map dump for all original vRegs
+  //profiler->dumpOrigVRegMappings();
+  {
+    TimeTraceScope timeScope("RegAllocProfilerDump", profiler->getFunctionName());
+    profiler->dumpProfStatsToSink(sink);
+    profiler->dumpProfStatsToTrace(trace);
+  }
+
+  profiler.reset();
+} 
+
 /********************* Private Methods *******************************/
 
-// Populates the map with each physical reg name and it's mapped virtregs
+// Populates the per-class buckets with each allocated virtReg
 // 10/31 Update: Updated this method to explicitly check for spilling. If a spilled 
 // vReg is found, it wil updated the spill counter and will update the vReg's entry in
 // origVRegInfo with the corresponding boolean value (1 for physReg mapping, 0 for spill)
+// Everything is bucketed by register class ID with a counting sort, so there are no
+// per-vReg node allocations or string compares
 void RegAllocProfiler::populateRegisterClassMap() {
 
-  // Go through every virtual register, and check if it's actually used or not
-  // If it is, get the register class name and add it to our register class map
-  // Since we have a nested map, we need to add the register name and the virtual register index to our struct
-
+  origVRegInfo.clear();
+  origVRegInfo.resize(nominalVirtRegs);
+  classNumVRegs.assign(numClassBuckets, 0);
+  classAllocBegin.assign(numClassBuckets + 1, 0);
 
+  // Go through every original virtual register and check whether it ended up in a physReg.
+  // Count the allocated ones per class so the class slices can be laid out afterwards
   for (auto virtReg : originalVRegSet) {
 
-    const bool isInSplitSet = splitMarkedVRegs->find(virtReg) != splitMarkedVRegs->end();
-
-    /*
-    errs() << "Num split vregs: " << splitMarkedVRegs->size() << '\n';
-
-    for (auto vreg : *splitMarkedVRegs) {
-      errs() << "spilled reg: " << Register::virtReg2Index(vreg) << '\n';
-    } 
-
-    if (isInSplitSet)
-      errs() << "REGISTER: " << Register::virtReg2Index(virtReg) << "is spilled!" << '\n';
-      */
+    const bool isInSplitSet = splitMarkedVRegs.contains(virtReg);
+    unsigned classID = getRegClassID(virtReg);
 
     // 11/10 - added checking for split-marked vRegs
     if (isSpilled(virtReg) || isInSplitSet) {
       numSpilledVirtRegs++; 
       spilledVRegs.push_back(virtReg);
-
-      // get data for all vReg classes
-      auto regClassName = getRegClassName(virtReg);
-      vRegClassData[regClassName].push_back(virtReg);
-
-      origVRegInfo[virtReg] = false; 
+      classNumVRegs[classID]++;
     } 
     else if (isMappedToPhysReg(virtReg)) {
       allocatedVirtRegs++;
       allocatedVRegs.push_back(virtReg);
-      origVRegInfo[virtReg] = true;
-
-      auto regClassName = getRegClassName(virtReg);
-      auto regAsmName = getPhysRegName(virtReg);
-
-      vRegClassData[regClassName].push_back(virtReg);
-      // add to the number of used virtRegs; 
-      regClassMap[regClassName].nmap[regAsmName].push_back(virtReg);
+      origVRegInfo.set(Register::virtReg2Index(virtReg));
+      classNumVRegs[classID]++;
+      classAllocBegin[classID + 1]++;
     } 
     else {
       errs() << "No information for this virtual Register found!: " << virtReg << '\n';
@@ -323,34 +1231,32 @@ void RegAllocProfiler::populateRegisterClassMap() {
 
   } 
 
+  // prefix sum turns the per-class counts into slice offsets
+  for (unsigned classID = 0; classID < numClassBuckets; ++classID)
+    classAllocBegin[classID + 1] += classAllocBegin[classID];
+
+  SmallVector<unsigned, 32> insertPos(classAllocBegin.begin(), classAllocBegin.end() - 1);
+  classAllocVRegs.resize(allocatedVRegs.size());
+  for (auto virtReg : allocatedVRegs)
+    classAllocVRegs[insertPos[getRegClassID(virtReg)]++] = virtReg;
+
 }
                                     
 void RegAllocProfiler::calculateProfilerStats() { 
 
   numUsedVirtRegs = originalVRegSet.size();
+
+  classUniquePhysRegs.assign(numClassBuckets, 0);
+  physRegStamp.assign(TRI->getNumRegs(), 0);
    
-  for (auto const& pair : regClassMap) {
+  for (unsigned classID = 0; classID < numClassBuckets; ++classID) {
     // calculate the unique number of GPRs allocated in this class
-    regClassData[pair.first].first = pair.second.nmap.size(); 
-
-    for (auto const& mappings: pair.second.nmap) { 
-      //calculate the number of virtregs allocated to each class
-      regClassData[pair.first].second += mappings.second.size();
+    for (unsigned i = classAllocBegin[classID]; i != classAllocBegin[classID + 1]; ++i) {
+      unsigned physReg = regMap[classAllocVRegs[i]];
+      if (physRegStamp[physReg] != classID + 1) {
+        physRegStamp[physReg] = classID + 1;
+        classUniquePhysRegs[classID]++;
+      }
     }
   }
 }
-
-// checks with the MF to get all the actual virtRegs used in 
-// MachineInstructions, and adds them to the original vReg set
-void RegAllocProfiler::getOriginalVRegs() {
-
-  for (unsigned i = 0; i < nominalVirtRegs; ++i) { 
-    unsigned Reg = Register::index2VirtReg(i);
-    if (MRI->reg_nodbg_empty(Reg))
-      continue;
-    originalVRegSet.push_back(Reg);
-
-  } 
-
-} 
-
@@ -0,0 +1,51 @@
+#include "llvm/CodeGen/RegAllocQueueStats.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace llvm;
+
+const char* getRegAllocStageName(unsigned stage) {
+  // keep in sync with RAGreedy::LiveRangeStage
+  static const char* const Names[RegAllocQueueStats::NumStages] = {
+    "New", "Assign", "Split", "Split2", "Spill", "Memory", "Done"
+  };
+  if (stage >= RegAllocQueueStats::NumStages)
+    llvm_unreachable("invalid live range stage");
+  return Names[stage];
+}
+
+void RegAllocQueueStats::clear(unsigned numVirtRegs) {
+  numEnqueues = 0;
+  numDequeues = 0;
+  numDroppedUnused = 0;
+  depthSamples.clear();
+  maxDepth = 0;
+  origDequeues.assign(numVirtRegs, 0);
+  for (auto& count : stageDequeues)
+    count = 0;
+  for (auto& row : transitions)
+    for (auto& count : row)
+      count = 0;
+}
+
+double RegAllocQueueStats::getMeanDepth() const {
+  if (depthSamples.empty())
+    return 0;
+
+  uint64_t sum = 0;
+  for (uint32_t depth : depthSamples)
+    sum += depth;
+  return (double)sum / depthSamples.size();
+}
+
+void RegAllocQueueStats::getOrigDequeueHistogram(ArrayRef<Register> origVRegs,
+                                                 std::vector<uint32_t>& histogram) const {
+  histogram.clear();
+  for (Register orig : origVRegs) {
+    uint32_t count = getOrigDequeues(orig);
+    unsigned bucket = count ? Log2_32(count) + 1 : 0;
+    if (bucket >= histogram.size())
+      histogram.resize(bucket + 1, 0);
+    histogram[bucket]++;
+  }
+}
@@ -0,0 +1,31 @@
+#include "llvm/CodeGen/RegAllocRegionSplitStats.h"
+#include <cassert>
+
+using namespace llvm;
+
+void RegAllocRegionSplitStats::clear() {
+  splits.clear();
+  inSplit = false;
+  current = RegAllocRegionSplit();
+  totals = RegAllocRegionSplit();
+}
+
+void RegAllocRegionSplitStats::beginSplit(Register reg, unsigned size, unsigned throughBlocks,
+                                          uint64_t spillCost) {
+  assert(!inSplit && "nested region split attempts!");
+  inSplit = true;
+  current = RegAllocRegionSplit();
+  current.vReg = Register::virtReg2Index(reg);
+  current.size = size;
+  current.throughBlocks = throughBlocks;
+  current.spillCost = spillCost;
+}
+
+void RegAllocRegionSplitStats::endSplit(uint64_t bestCost, bool compact, bool foundCandidate) {
+  assert(inSplit && "no region split attempt in progress!");
+  inSplit = false;
+  current.bestCost = bestCost;
+  current.flags = (compact ? RegAllocRegionSplit::RSF_Compact : 0) |
+                  (foundCandidate ? RegAllocRegionSplit::RSF_FoundCandidate : 0);
+  splits.push_back(current);
+}
@@ -0,0 +1,158 @@
+#include "llvm/CodeGen/RegAllocSpillCost.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/PseudoSourceValue.h"
+#include "llvm/CodeGen/TargetInstrInfo.h"
+#include "llvm/CodeGen/TargetSubtargetInfo.h"
+
+using namespace llvm;
+
+const char* getRegAllocSpillKindName(RegAllocSpillKind kind) {
+  switch (kind) {
+  case RSK_Spill: return "Spills";
+  case RSK_Reload: return "Reloads";
+  case RSK_FoldedSpill: return "FoldedSpills";
+  case RSK_FoldedReload: return "FoldedReloads";
+  case RSK_Remat: return "Remats";
+  default: return "Unknown";
+  }
+}
+
+bool RegAllocSpillCost::empty() const {
+  for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+    if (counts[kind])
+      return false;
+  return true;
+}
+
+double RegAllocSpillCost::getTotalWeight() const {
+  double total = 0;
+  for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+    total += weights[kind];
+  return total;
+}
+
+double RegAllocSpillCycles::getTotalLatency() const {
+  double total = 0;
+  for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+    total += latency[kind];
+  return total;
+}
+
+double RegAllocSpillCycles::getTotalReciprocalThroughput() const {
+  double total = 0;
+  for (unsigned kind = 0; kind < RSK_NumKinds; ++kind)
+    total += reciprocalThroughput[kind];
+  return total;
+}
+
+void RegAllocSpillCostStats::clear(const MachineFunction* MF, const VirtRegMap* VRM,
+                                   const MachineRegisterInfo* MRI,
+                                   const MachineBlockFrequencyInfo* MBFI, bool priceCycles) {
+  this->MF = MF;
+  this->VRM = VRM;
+  this->MRI = MRI;
+  this->MBFI = MBFI;
+  originalVRegs.clear();
+  origDefs.clear();
+  slotOwners.clear();
+  vRegCosts.assign(MRI->getNumVirtRegs(), RegAllocSpillCost());
+  totals = RegAllocSpillCost();
+  this->priceCycles = priceCycles;
+  cycles = RegAllocSpillCycles();
+  if (priceCycles)
+    schedModel.init(&MF->getSubtarget());
+}
+
+void RegAllocSpillCostStats::addOriginalVReg(Register reg) {
+  originalVRegs.push_back(reg);
+  for (const MachineInstr& MI : MRI->def_instructions(reg))
+    origDefs.insert(&MI);
+}
+
+Register RegAllocSpillCostStats::getSlotOwner(int FI) const {
+  auto it = slotOwners.find(FI);
+  return it == slotOwners.end() ? Register() : it->second;
+}
+
+Register RegAllocSpillCostStats::getSlotOwner(ArrayRef<const MachineMemOperand*> accesses) const {
+  for (const MachineMemOperand* A : accesses) {
+    int FI = cast<FixedStackPseudoSourceValue>(A->getPseudoValue())->getFrameIndex();
+    if (Register owner = getSlotOwner(FI))
+      return owner;
+  }
+  return Register();
+}
+
+bool RegAllocSpillCostStats::classify(const MachineInstr& MI, RegAllocSpillKind& kind,
+                                      Register& reg) const {
+  const MachineFrameInfo& MFI = MF->getFrameInfo();
+  const TargetInstrInfo* TII = MF->getSubtarget().getInstrInfo();
+  SmallVector<const MachineMemOperand*, 2> accesses;
+  int FI;
+
+  auto isSpillSlotAccess = [&MFI](const MachineMemOperand* A) {
+    return MFI.isSpillSlotObjectIndex(
+        cast<FixedStackPseudoSourceValue>(A->getPseudoValue())->getFrameIndex());
+  };
+
+  if (TII->isLoadFromStackSlot(MI, FI) && MFI.isSpillSlotObjectIndex(FI)) {
+    kind = RSK_Reload;
+    reg = getSlotOwner(FI);
+    return true;
+  }
+  if (TII->hasLoadFromStackSlot(MI, accesses) && any_of(accesses, isSpillSlotAccess)) {
+    kind = RSK_FoldedReload;
+    reg = getSlotOwner(accesses);
+    return true;
+  }
+  if (TII->isStoreToStackSlot(MI, FI) && MFI.isSpillSlotObjectIndex(FI)) {
+    kind = RSK_Spill;
+    reg = getSlotOwner(FI);
+    return true;
+  }
+  accesses.clear();
+  if (TII->hasStoreToStackSlot(MI, accesses) && any_of(accesses, isSpillSlotAccess)) {
+    kind = RSK_FoldedSpill;
+    reg = getSlotOwner(accesses);
+    return true;
+  }
+
+  // split copies are no spill code
+  if (MI.isCopyLike() || MI.isDebugInstr() || !MI.getNumOperands())
+    return false;
+  const MachineOperand& def = MI.getOperand(0);
+  if (!def.isReg() || !def.isDef() || !Register::isVirtualRegister(def.getReg()))
+    return false;
+  unsigned original = VRM->getOriginal(def.getReg());
+  if (original == def.getReg() || origDefs.count(&MI))
+    return false;
+  kind = RSK_Remat;
+  reg = original;
+  return true;
+}
+
+void RegAllocSpillCostStats::compute() {
+  for (Register reg : originalVRegs) {
+    int slot = VRM->getStackSlot(reg);
+    if (slot != VirtRegMap::NO_STACK_SLOT)
+      slotOwners[slot] = reg;
+  }
+
+  for (const MachineBasicBlock& MBB : *MF) {
+    double freq = MBFI->getBlockFreqRelativeToEntryBlock(&MBB);
+    for (const MachineInstr& MI : MBB) {
+      RegAllocSpillKind kind;
+      Register reg;
+      if (!classify(MI, kind, reg))
+        continue;
+      totals.add(kind, freq);
+      if (priceCycles) {
+        cycles.latency[kind] += freq * schedModel.computeInstrLatency(&MI);
+        cycles.reciprocalThroughput[kind] += freq * schedModel.computeReciprocalThroughput(&MI);
+      }
+      if (reg && Register::virtReg2Index(reg) < vRegCosts.size())
+        vRegCosts[Register::virtReg2Index(reg)].add(kind, freq);
+    }
+  }
+}
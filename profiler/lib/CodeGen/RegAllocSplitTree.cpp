@@ -0,0 +1,121 @@
+#include "llvm/CodeGen/RegAllocSplitTree.h"
+
+using namespace llvm;
+
+const char* getRegAllocSplitKindName(RegAllocSplitKind kind) {
+  switch (kind) {
+  case RSP_Original: return "Original";
+  case RSP_Region: return "Region";
+  case RSP_Block: return "Block";
+  case RSP_Local: return "Local";
+  case RSP_Instruction: return "Instruction";
+  case RSP_Spill: return "Spill";
+  case RSP_Clone: return "Clone";
+  default: return "Unknown";
+  }
+}
+
+void RegAllocSplitTree::clear(const VirtRegMap* VRM, const MachineRegisterInfo* MRI,
+                              LiveIntervals* LIS) {
+  this->VRM = VRM;
+  this->MRI = MRI;
+  this->LIS = LIS;
+  nodes.clear();
+  nodeOf.assign(MRI->getNumVirtRegs(), ~0u);
+  regFractions.clear();
+}
+
+RegAllocSplitNode* RegAllocSplitTree::find(Register reg) {
+  unsigned index = Register::virtReg2Index(reg);
+  if (index >= nodeOf.size() || nodeOf[index] == ~0u)
+    return nullptr;
+  return &nodes[nodeOf[index]];
+}
+
+void RegAllocSplitTree::addNode(Register reg, Register parent, RegAllocSplitKind kind) {
+  unsigned index = Register::virtReg2Index(reg);
+  if (index >= nodeOf.size())
+    nodeOf.resize(MRI->getNumVirtRegs(), ~0u);
+  // dead code elimination during a split reports its clones before the split products
+  if (nodeOf[index] != ~0u)
+    return;
+
+  RegAllocSplitNode node;
+  node.vReg = index;
+  node.parent = Register::virtReg2Index(parent);
+  node.original = Register::virtReg2Index(VRM->getOriginal(reg));
+  node.size = LIS->hasInterval(reg) ? LIS->getInterval(reg).getSize() : 0;
+  node.kind = kind;
+  node.location = RSL_Unassigned;
+  node.hasChildren = false;
+  node.spilled = false;
+  nodeOf[index] = nodes.size();
+  nodes.push_back(node);
+
+  if (RegAllocSplitNode* parentNode = find(parent))
+    parentNode->hasChildren = true;
+}
+
+void RegAllocSplitTree::addOriginal(const LiveInterval& LI) {
+  addNode(LI.reg, LI.reg, RSP_Original);
+}
+
+void RegAllocSplitTree::recordSplit(RegAllocSplitKind kind, Register parent,
+                                    ArrayRef<unsigned> children) {
+  for (unsigned child : children)
+    addNode(child, parent, kind);
+}
+
+void RegAllocSplitTree::recordSpill(Register reg, ArrayRef<unsigned> products) {
+  if (RegAllocSplitNode* node = find(reg))
+    node->spilled = true;
+  recordSplit(RSP_Spill, reg, products);
+}
+
+void RegAllocSplitTree::compute() {
+  // register and stack sizes of each original, indexed like nodes
+  std::vector<std::pair<double, double>> sizes(nodes.size());
+
+  for (RegAllocSplitNode& node : nodes) {
+    Register reg = Register::index2VirtReg(node.vReg);
+    bool hasUses = !MRI->reg_nodbg_empty(reg);
+    uint32_t size = node.size;
+
+    if (node.spilled)
+      node.location = RSL_Stack;
+    else if (hasUses && VRM->hasPhys(reg)) {
+      node.location = RSL_Register;
+      // clones may have taken parts of the range since the node was created
+      if (LIS->hasInterval(reg))
+        size = LIS->getInterval(reg).getSize();
+    } 
+    else if (hasUses)
+      node.location = RSL_Unassigned;
+    else if (node.hasChildren)
+      node.location = RSL_Split;
+    else
+      node.location = RSL_Dead;
+
+    unsigned index = node.original < nodeOf.size() ? nodeOf[node.original] : ~0u;
+    if (index == ~0u || node.kind == RSP_Spill)
+      continue;
+    if (node.location == RSL_Register)
+      sizes[index].first += size;
+    else if (node.location == RSL_Stack)
+      sizes[index].second += size;
+  }
+
+  regFractions.assign(nodes.size(), 0);
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i) {
+    double total = sizes[i].first + sizes[i].second;
+    if (total > 0)
+      regFractions[i] = sizes[i].first / total;
+  }
+}
+
+float RegAllocSplitTree::getRegFraction(Register original) const {
+  unsigned index = Register::virtReg2Index(original);
+  if (index >= nodeOf.size() || nodeOf[index] == ~0u || regFractions.empty())
+    return 0;
+  return regFractions[nodeOf[index]];
+}
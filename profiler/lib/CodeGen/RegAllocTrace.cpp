@@ -0,0 +1,195 @@
+#include "llvm/CodeGen/RegAllocTrace.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include <cassert>
+#include <system_error>
+
+using namespace llvm;
+
+/********************* RegAllocTraceTable *******************************/
+
+RegAllocTraceTable::RegAllocTraceTable(RegAllocTraceWriter& writer, StringRef name,
+                                       ArrayRef<RegAllocTrace::ColumnDesc> columns)
+    : writer(writer), name(name), numRows(0), nextColumn(0) {
+  for (const auto& desc : columns) {
+    this->columns.emplace_back();
+    this->columns.back().name = desc.name;
+    this->columns.back().type = desc.type;
+  }
+}
+
+RegAllocTraceTable& RegAllocTraceTable::addF32(float value) {
+  return add(RegAllocTrace::CT_F32, FloatToBits(value));
+}
+
+RegAllocTraceTable& RegAllocTraceTable::addStr(StringRef value) {
+  return add(RegAllocTrace::CT_Str, writer.internString(value));
+}
+
+/********************* RegAllocTraceWriter *******************************/
+
+bool RegAllocTraceWriter::open(StringRef fname, size_t threshold) {
+  close();
+  flushThreshold = threshold;
+
+  std::error_code EC;
+  out = std::make_unique<raw_fd_ostream>(fname, EC, sys::fs::OF_Append);
+  if (EC) {
+    errs() << "warning: could not open regalloc trace file '" << fname << "': " << EC.message() << '\n';
+    out.reset();
+    return false;
+  }
+
+  // chunks are serialized in memory first, so write them straight through
+  out->SetUnbuffered();
+  return true;
+}
+
+void RegAllocTraceWriter::close() {
+  if (!out)
+    return;
+
+  writeChunk();
+  out->close();
+  out.reset();
+}
+
+uint32_t RegAllocTraceWriter::internString(StringRef str) {
+  auto insertion = stringIds.insert(std::make_pair(str, (uint32_t)strings.size()));
+  if (insertion.second) {
+    // the StringMap owns the key, so the table can keep referring to it
+    strings.push_back(insertion.first->getKey());
+    stringBytes += str.size();
+  }
+  return insertion.first->second;
+}
+
+RegAllocTraceTable& RegAllocTraceWriter::table(StringRef name,
+                                               ArrayRef<RegAllocTrace::ColumnDesc> columns) {
+  RegAllocTraceTable*& entry = tablesByName[name];
+  if (!entry) {
+    tables.push_back(std::make_unique<RegAllocTraceTable>(*this, name, columns));
+    entry = tables.back().get();
+  }
+  assert(entry->columns.size() == columns.size() && "table redeclared with other columns!");
+  return *entry;
+}
+
+size_t RegAllocTraceWriter::pendingBytes() const {
+  size_t bytes = stringBytes;
+  for (const auto& table : tables)
+    for (const auto& column : table->columns)
+      bytes += column.data.size();
+  return bytes;
+}
+
+void RegAllocTraceWriter::endFunction() {
+  if (pendingBytes() >= flushThreshold)
+    writeChunk();
+}
+
+// pads the chunk to the next 8 byte boundary so every column is aligned
+static void alignTo8(SmallVectorImpl<char>& chunk) {
+  chunk.resize(alignTo(chunk.size(), 8), 0);
+}
+
+void RegAllocTraceWriter::writeChunk() {
+  if (!out || !TRI)
+    return;
+
+  bool hasRows = false;
+  for (const auto& table : tables)
+    hasRows |= table->size() != 0;
+  if (!hasRows)
+    return;
+
+  // target name tables, so the IDs in the other tables can be resolved
+  static const RegAllocTrace::ColumnDesc NameColumns[] = {{"name", RegAllocTrace::CT_Str}};
+  RegAllocTraceTable& regClasses = table("regclasses", NameColumns);
+  for (unsigned classID = 0, e = TRI->getNumRegClasses(); classID != e; ++classID) {
+    regClasses.addStr(TRI->getRegClassName(TRI->getRegClass(classID)));
+    regClasses.endRow();
+  }
+  RegAllocTraceTable& physRegs = table("physregs", NameColumns);
+  for (unsigned physReg = 0, e = TRI->getNumRegs(); physReg != e; ++physReg) {
+    physRegs.addStr(TRI->getName(physReg));
+    physRegs.endRow();
+  }
+
+  // table and column names go through the string table too
+  SmallVector<uint32_t, 16> tableNames;
+  SmallVector<SmallVector<uint32_t, 8>, 16> columnNames;
+  unsigned numTables = 0;
+  for (const auto& table : tables) {
+    tableNames.push_back(internString(table->name));
+    columnNames.emplace_back();
+    for (const auto& column : table->columns)
+      columnNames.back().push_back(internString(column.name));
+    numTables += table->size() != 0;
+  }
+
+  SmallVector<char, 0> chunk;
+  chunk.reserve(pendingBytes() + 4 * strings.size() + 64 * tables.size() + 256);
+  raw_svector_ostream OS(chunk);
+  support::endian::Writer W(OS, support::little);
+
+  // header - the chunk size is patched in once everything is serialized
+  OS.write(RegAllocTrace::Magic, sizeof(RegAllocTrace::Magic));
+  W.write<uint16_t>(RegAllocTrace::Version);
+  W.write<uint16_t>(RegAllocTrace::HeaderSize);
+  W.write<uint32_t>(strings.size());
+  W.write<uint32_t>(stringBytes);
+  W.write<uint32_t>(numTables);
+  const size_t chunkSizeOffset = chunk.size();
+  W.write<uint64_t>(0);
+  assert(chunk.size() == RegAllocTrace::HeaderSize && "header layout changed!");
+
+  // string table
+  uint32_t offset = 0;
+  for (StringRef str : strings) {
+    W.write<uint32_t>(offset);
+    offset += str.size();
+  }
+  W.write<uint32_t>(offset);
+  for (StringRef str : strings)
+    OS << str;
+  alignTo8(chunk);
+
+  // tables
+  for (unsigned t = 0, e = tables.size(); t != e; ++t) {
+    const RegAllocTraceTable& table = *tables[t];
+    if (!table.size())
+      continue;
+
+    W.write<uint32_t>(tableNames[t]);
+    W.write<uint32_t>(table.columns.size());
+    W.write<uint64_t>(table.size());
+    for (unsigned c = 0, ce = table.columns.size(); c != ce; ++c) {
+      W.write<uint32_t>(columnNames[t][c]);
+      W.write<uint8_t>(table.columns[c].type);
+      OS.write_zeros(3);
+    }
+    alignTo8(chunk);
+
+    for (const auto& column : table.columns) {
+      OS.write(column.data.data(), column.data.size());
+      alignTo8(chunk);
+    }
+  }
+
+  support::endian::write64le(chunk.data() + chunkSizeOffset, chunk.size());
+  out->write(chunk.data(), chunk.size());
+
+  // start the next chunk from scratch - string ids are chunk local
+  stringIds.clear();
+  strings.clear();
+  stringBytes = 0;
+  for (auto& table : tables) {
+    assert(!table->nextColumn && "chunk written in the middle of a row!");
+    table->numRows = 0;
+    for (auto& column : table->columns)
+      column.data.clear();
+  }
+}
@@ -0,0 +1,110 @@
+import argparse
+import filecmp
+import os
+import random
+import re
+import statistics
+import subprocess
+import tempfile
+
+from bench_llc import time_llc
+
+'''
+Benchmarks the local split gap weight kernels (-regalloc-gap-kernel) against the scalar path
+
+Generates single block functions in which one value has 1k - 100k uses while a set of
+accumulators keeps the register pressure above the register file, so RAGreedy local splits
+it over the whole block. For every input this checks that each kernel emits the same
+assembly as the scalar loops, then times llc per kernel and reads the "Local Splitting"
+wall time from -time-passes, which is where the kernels run.
+
+Example:
+
+    python3 bench_gap_kernel.py --llc 10.0.0/bin/llc --num_uses 1000 10000 100000
+'''
+
+KERNELS = ['scalar', 'sse2', 'avx2']
+
+# -time-passes row of the local split timer: "<wall> (<pct>%)  Local Splitting"
+LOCAL_SPLIT_ROW = re.compile(r'([0-9.]+) \(\s*[0-9.]+%\)\s+Local Splitting\s*$', re.MULTILINE)
+
+
+def create_gap_prog(fname, num_uses, num_accs):
+    lines = ['define void @gaps(i64* %p, i64 %v) {', 'entry:']
+    accs = []
+    for a in range(num_accs):
+        lines.append('  %p{0} = getelementptr i64, i64* %p, i64 {0}'.format(a))
+        lines.append('  %acc{0}.0 = load volatile i64, i64* %p{0}'.format(a))
+        accs.append('%acc{}.0'.format(a))
+
+    # every use of %v sits between accumulator updates, all accumulators stay live
+    for u in range(num_uses):
+        a = u % num_accs
+        lines.append('  %m{} = xor i64 %v, {}'.format(u, random.randint(1, 1 << 30)))
+        lines.append('  %acc{}.{} = add i64 {}, %m{}'.format(a, u + 1, accs[a], u))
+        accs[a] = '%acc{}.{}'.format(a, u + 1)
+
+    for a in range(num_accs):
+        lines.append('  store volatile i64 {}, i64* %p{}'.format(accs[a], a))
+    lines.append('  ret void')
+    lines.append('}')
+
+    with open(fname, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def emit_asm(llc, ir_file, kernel, workdir):
+    out = os.path.join(workdir, '{}.{}.s'.format(os.path.basename(ir_file), kernel))
+    subprocess.check_call([llc, '-O2', '-regalloc=greedy', '-regalloc-gap-kernel=' + kernel,
+                           ir_file, '-o', out], cwd=workdir)
+    return out
+
+
+def local_split_time(llc, ir_file, kernel, workdir):
+    result = subprocess.run([llc, '-O2', '-regalloc=greedy', '-regalloc-gap-kernel=' + kernel,
+                             '-time-passes', ir_file, '-o', os.devnull],
+                            cwd=workdir, stderr=subprocess.PIPE, universal_newlines=True, check=True)
+    rows = LOCAL_SPLIT_ROW.findall(result.stderr)
+    return float(rows[-1]) if rows else 0.0
+
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(description="Benchmarks the local split gap weight kernels")
+    parser.add_argument('--llc', metavar='L', type=str, required=True, help="llc built with the profiler patch")
+    parser.add_argument('--num_uses', metavar='N', type=int, nargs='+', default=[1000, 10000, 100000],
+                        help="uses of the local split value per generated function")
+    parser.add_argument('--num_accs', metavar='A', type=int, default=24,
+                        help="accumulators kept live across the block")
+    parser.add_argument('--kernels', metavar='K', type=str, nargs='+', default=KERNELS, choices=KERNELS,
+                        help="kernels to compare, the first one is the baseline")
+    parser.add_argument('--seed', metavar='S', type=int, default=0, help="seed of the program generator")
+    parser.add_argument('--runs', metavar='R', type=int, default=5, help="timed runs per kernel and input")
+    args = parser.parse_args()
+
+    llc = os.path.abspath(os.path.expanduser(args.llc))
+    random.seed(args.seed)
+
+    with tempfile.TemporaryDirectory() as workdir:
+        for num_uses in args.num_uses:
+            ir_file = os.path.join(workdir, 'gaps_{}.ll'.format(num_uses))
+            create_gap_prog(ir_file, num_uses, args.num_accs)
+
+            asm = [emit_asm(llc, ir_file, kernel, workdir) for kernel in args.kernels]
+            identical = all(filecmp.cmp(asm[0], other, shallow=False) for other in asm[1:])
+
+            split_times = {kernel: [] for kernel in args.kernels}
+            llc_times = {kernel: [] for kernel in args.kernels}
+            for _ in range(args.runs):
+                for kernel in args.kernels:
+                    split_times[kernel].append(local_split_time(llc, ir_file, kernel, workdir))
+                    llc_times[kernel].append(time_llc([llc, '-regalloc-gap-kernel=' + kernel],
+                                                      ir_file, workdir))
+
+            print('{} uses ({})'.format(num_uses, 'identical output' if identical else 'OUTPUT DIFFERS'))
+            baseline = statistics.median(split_times[args.kernels[0]])
+            for kernel in args.kernels:
+                split = statistics.median(split_times[kernel])
+                speedup = baseline / split if split else float('nan')
+                print('  {:<8} local split {:8.4f}s  {:5.2f}x vs {}  llc {:8.4f}s'.format(
+                    kernel, split, speedup, args.kernels[0], statistics.median(llc_times[kernel])))
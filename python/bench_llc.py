@@ -0,0 +1,86 @@
+import argparse
+import os
+import statistics
+import subprocess
+import tempfile
+import time
+
+'''
+Times llc on a set of inputs for several llc builds / flag combinations
+
+Each configuration is "label=path/to/llc [extra llc flags]". Inputs may be .ll/.bc files or
+C files (compiled once with clang -O2 -emit-llvm). Every configuration runs on every input
+--runs times in interleaved order so machine noise hits all configurations alike, and the
+median/stdev of the wall time is reported per configuration.
+
+Example - profiler compiled in but disabled vs. stock LLVM 10:
+
+    python3 bench_llc.py --config stock=~/llvm-10-stock/bin/llc \
+                         --config disabled=10.0.0/bin/llc \
+                         --config enabled="10.0.0/bin/llc -regalloc-profile" \
+                         ../tests/pressure/scratch.c ../tests/gemm/main.c
+'''
+
+
+def parse_config(spec):
+    label, _, cmd = spec.partition('=')
+    if not cmd:
+        raise argparse.ArgumentTypeError("expected label=llc [flags], got '{}'".format(spec))
+    cmd = os.path.expanduser(cmd).split()
+    # llc runs inside a scratch directory, so pin relative binary paths down now
+    if os.sep in cmd[0]:
+        cmd[0] = os.path.abspath(cmd[0])
+    return label, cmd
+
+
+def prepare_inputs(inputs, clang, workdir):
+    ir_files = []
+    for src in inputs:
+        if src.endswith('.c'):
+            out = os.path.join(workdir, os.path.basename(src) + '.ll')
+            subprocess.check_call([clang, '-O2', '-S', '-emit-llvm', src, '-o', out])
+            ir_files.append(out)
+        else:
+            ir_files.append(os.path.abspath(src))
+    return ir_files
+
+
+def time_llc(cmd, ir_file, workdir):
+    out = os.path.join(workdir, 'bench.o')
+    start = time.perf_counter()
+    subprocess.check_call(cmd + ['-O2', '-filetype=obj', '-regalloc=greedy', ir_file, '-o', out],
+                          cwd=workdir)
+    return time.perf_counter() - start
+
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(description="Benchmarks llc register allocation configurations")
+    parser.add_argument('inputs', metavar='I', type=str, nargs='+', help="C or LLVM IR inputs")
+    parser.add_argument('--config', metavar='C', type=parse_config, action='append', required=True,
+                        help="label=llc [flags], may be repeated")
+    parser.add_argument('--runs', metavar='N', type=int, default=10, help="timed runs per configuration and input")
+    parser.add_argument('--clang', metavar='CC', type=str, default='clang', help="clang used to lower C inputs")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as workdir:
+        ir_files = prepare_inputs(args.inputs, args.clang, workdir)
+
+        for ir_file in ir_files:
+            times = {label: [] for label, _ in args.config}
+
+            # warm up the page cache once per configuration
+            for label, cmd in args.config:
+                time_llc(cmd, ir_file, workdir)
+
+            for _ in range(args.runs):
+                for label, cmd in args.config:
+                    times[label].append(time_llc(cmd, ir_file, workdir))
+
+            print(os.path.basename(ir_file))
+            baseline = statistics.median(times[args.config[0][0]])
+            for label, _ in args.config:
+                median = statistics.median(times[label])
+                stdev = statistics.stdev(times[label]) if len(times[label]) > 1 else 0.0
+                print('  {:<16} median {:8.4f}s  stdev {:7.4f}s  {:+6.2f}% vs {}'.format(
+                    label, median, stdev, 100.0 * (median - baseline) / baseline, args.config[0][0]))
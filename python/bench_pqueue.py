@@ -0,0 +1,79 @@
+import argparse
+import filecmp
+import os
+import random
+import statistics
+import subprocess
+import tempfile
+
+from bench_llc import prepare_inputs, time_llc
+from gen_serial_c import create_serial_prog
+
+'''
+Benchmarks RAGreedy's work queue implementations (-regalloc-pqueue) against each other
+
+Generates register pressure programs of increasing size with gen_serial_c.py (the generator
+behind tests/pressure), checks that every queue implementation emits the same assembly, and
+then times llc per implementation the way bench_llc.py does.
+
+Example:
+
+    python3 bench_pqueue.py --llc 10.0.0/bin/llc --num_sets 200 800 3200 ../tests/pressure/scratch.c
+'''
+
+QUEUES = ['binary', 'bucketed']
+FUNC_PARAMS = ['x', 'n', 'a', 'b', 'c']
+
+
+def generate_inputs(num_sets, seed, workdir):
+    random.seed(seed)
+    sources = []
+    for n in num_sets:
+        src = os.path.join(workdir, 'pressure_{}.c'.format(n))
+        create_serial_prog(src, FUNC_PARAMS, n)
+        sources.append(src)
+    return sources
+
+
+def emit_asm(cmd, ir_file, workdir, label):
+    out = os.path.join(workdir, '{}.{}.s'.format(os.path.basename(ir_file), label))
+    subprocess.check_call(cmd + ['-O2', '-regalloc=greedy', ir_file, '-o', out], cwd=workdir)
+    return out
+
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(description="Benchmarks RAGreedy's priority queue implementations")
+    parser.add_argument('inputs', metavar='I', type=str, nargs='*', help="additional C or LLVM IR inputs")
+    parser.add_argument('--llc', metavar='L', type=str, required=True, help="llc built with the profiler patch")
+    parser.add_argument('--num_sets', metavar='N', type=int, nargs='+', default=[200, 800, 3200],
+                        help="variable sets of the generated pressure programs")
+    parser.add_argument('--seed', metavar='S', type=int, default=0, help="seed of the program generator")
+    parser.add_argument('--runs', metavar='R', type=int, default=10, help="timed runs per queue and input")
+    parser.add_argument('--clang', metavar='CC', type=str, default='clang', help="clang used to lower C inputs")
+    args = parser.parse_args()
+
+    llc = os.path.abspath(os.path.expanduser(args.llc))
+    configs = [(queue, [llc, '-regalloc-pqueue=' + queue]) for queue in QUEUES]
+
+    with tempfile.TemporaryDirectory() as workdir:
+        sources = generate_inputs(args.num_sets, args.seed, workdir) + args.inputs
+        ir_files = prepare_inputs(sources, args.clang, workdir)
+
+        for ir_file in ir_files:
+            asm = [emit_asm(cmd, ir_file, workdir, label) for label, cmd in configs]
+            identical = all(filecmp.cmp(asm[0], other, shallow=False) for other in asm[1:])
+
+            times = {label: [] for label, _ in configs}
+            for _ in range(args.runs):
+                for label, cmd in configs:
+                    times[label].append(time_llc(cmd, ir_file, workdir))
+
+            print('{} ({})'.format(os.path.basename(ir_file),
+                                   'identical output' if identical else 'OUTPUT DIFFERS'))
+            baseline = statistics.median(times[QUEUES[0]])
+            for label, _ in configs:
+                median = statistics.median(times[label])
+                stdev = statistics.stdev(times[label]) if len(times[label]) > 1 else 0.0
+                print('  {:<16} median {:8.4f}s  stdev {:7.4f}s  {:+6.2f}% vs {}'.format(
+                    label, median, stdev, 100.0 * (median - baseline) / baseline, QUEUES[0]))
@@ -0,0 +1,102 @@
+import argparse
+import array
+import struct
+import sys
+
+'''
+Reads the binary columnar trace written by llc -regalloc-profile-trace=<file>
+
+The file is a sequence of self-contained chunks made of self-describing tables (see
+RegAllocTrace.h). Each chunk is loaded with a single read and every column is decoded
+straight into an array.array. String columns are resolved against the chunk's string table.
+'''
+
+MAGIC = b'RAPROFTR'
+SUPPORTED_VERSION = 2
+HEADER = struct.Struct('<8sHHIIIQ')
+TABLE_HEADER = struct.Struct('<IIQ')
+COLUMN_DESC = struct.Struct('<IB3x')
+
+# RegAllocTrace::ColumnType -> array typecode
+COLUMN_TYPECODES = ['B', 'H', 'I', 'Q', 'f', 'I']
+CT_STR = 5
+
+
+def align8(offset):
+    return (offset + 7) & ~7
+
+
+def read_column(buf, offset, typecode, count):
+    col = array.array(typecode)
+    end = offset + col.itemsize * count
+    col.frombytes(buf[offset:end])
+    if sys.byteorder != 'little':
+        col.byteswap()
+    return col, align8(end)
+
+
+def read_chunk(buf):
+    (magic, version, header_size, num_strings, string_bytes, num_tables,
+     chunk_size) = HEADER.unpack_from(buf, 0)
+
+    if magic != MAGIC:
+        raise ValueError('not a regalloc trace chunk')
+    if version != SUPPORTED_VERSION:
+        raise ValueError('unsupported trace version {}'.format(version))
+
+    offset = header_size
+    # the string bytes directly follow the offsets, the table is aligned as a whole
+    string_offsets, _ = read_column(buf, offset, 'I', num_strings + 1)
+    offset += 4 * (num_strings + 1)
+    string_blob = bytes(buf[offset:offset + string_bytes])
+    strings = [string_blob[string_offsets[i]:string_offsets[i + 1]].decode()
+               for i in range(num_strings)]
+    offset = align8(offset + string_bytes)
+
+    tables = {}
+    for _ in range(num_tables):
+        name, num_columns, num_rows = TABLE_HEADER.unpack_from(buf, offset)
+        offset += TABLE_HEADER.size
+
+        descs = []
+        for _ in range(num_columns):
+            descs.append(COLUMN_DESC.unpack_from(buf, offset))
+            offset += COLUMN_DESC.size
+        offset = align8(offset)
+
+        columns = {}
+        for column_name, column_type in descs:
+            col, offset = read_column(buf, offset, COLUMN_TYPECODES[column_type], num_rows)
+            if column_type == CT_STR:
+                col = [strings[i] for i in col]
+            columns[strings[column_name]] = col
+        tables[strings[name]] = columns
+
+    return tables, chunk_size
+
+
+def read_trace(fname):
+    with open(fname, 'rb') as f:
+        data = memoryview(f.read())
+
+    chunks = []
+    offset = 0
+    while offset < len(data):
+        chunk, size = read_chunk(data[offset:])
+        chunks.append(chunk)
+        offset += size
+    return chunks
+
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(description="Prints a summary of a binary register allocation trace")
+    parser.add_argument('trace', metavar='T', type=str, help="trace file written by -regalloc-profile-trace")
+    args = parser.parse_args()
+
+    for chunk in read_trace(args.trace):
+        fns = chunk['functions']
+        for i, name in enumerate(fns['name']):
+            print('{} used={} allocated={} spilled={} events={}'.format(
+                name, fns['used_vregs'][i], fns['allocated_vregs'][i], fns['spilled_vregs'][i],
+                fns['events'][i]))